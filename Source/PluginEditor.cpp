@@ -205,51 +205,51 @@ public:
     void tick(double newTimeSeconds)
     {
         timeSeconds = newTimeSeconds;
-        modulationEnergy = juce::jlimit(0.0f, 1.0f,
+        const auto newEnergy = juce::jlimit(0.0f, 1.0f,
             (processor.getDensity() / 5.0f) * 0.35f
             + (std::abs(processor.getPitch()) / 12.0f) * 0.2f
             + (processor.getReverse() * 0.2f)
             + (processor.getGrainDur() / 0.5f) * 0.25f);
 
-        reverseAmount = juce::jlimit(0.0f, 1.0f, processor.getReverse());
+        const auto newReverse = juce::jlimit(0.0f, 1.0f, processor.getReverse());
 
-        const auto snapshot = processor.getTrackedHands();
+        bool needsRepaint = newEnergy != modulationEnergy || newReverse != reverseAmount
+                            || isPythonOn != wasPythonOn;
+        modulationEnergy = newEnergy;
+        reverseAmount = newReverse;
+        wasPythonOn = isPythonOn;
+
+        // The tracker runs well below the 60 Hz timer, so most ticks see the frame they saw last
+        // time; only a new sequence carries new landmarks.
+        const auto& frame = processor.getLatestHandFrame();
+        const bool isNewFrame = frame.sequence != lastFrameSequence;
+        lastFrameSequence = frame.sequence;
 
         for (size_t handIndex = 0; handIndex < hands.size(); ++handIndex)
         {
             auto& displayState = hands[handIndex];
-            const auto& trackedHand = snapshot[handIndex];
 
-            if (trackedHand.visible)
+            if (isNewFrame)
             {
-                if (! displayState.seeded)
-                {
-                    displayState.smoothed = trackedHand.landmarks;
-                    displayState.seeded = true;
-                }
-                else
-                {
-                    for (size_t pointIndex = 0; pointIndex < displayState.smoothed.size(); ++pointIndex)
-                    {
-                        auto current = displayState.smoothed[pointIndex];
-                        const auto target = trackedHand.landmarks[pointIndex];
-                        displayState.smoothed[pointIndex] = {
-                            juce::jmap(0.28f, current.x, target.x),
-                            juce::jmap(0.28f, current.y, target.y)
-                        };
-                    }
-                }
+                const auto& trackedHand = frame.hands[handIndex];
+
+                // The processor already filters the landmarks, so they are drawn as they come
+                if (trackedHand.visible)
+                    displayState.landmarks = trackedHand.landmarks;
+
+                displayState.visible = trackedHand.visible;
+                needsRepaint = needsRepaint || trackedHand.visible;
             }
 
-            displayState.visible = trackedHand.visible;
-            displayState.visibility = juce::jlimit(0.0f, 1.0f,
-                displayState.visibility + (trackedHand.visible ? 0.12f : -0.08f));
+            const auto visibility = juce::jlimit(0.0f, 1.0f,
+                displayState.visibility + (displayState.visible ? 0.12f : -0.08f));
 
-            if (! trackedHand.visible && displayState.visibility <= 0.01f)
-                displayState.seeded = false;
+            needsRepaint = needsRepaint || visibility != displayState.visibility;
+            displayState.visibility = visibility;
         }
 
-        repaint();
+        if (needsRepaint)
+            repaint();
     }
 
     void paint(juce::Graphics& g) override
@@ -306,9 +306,8 @@ private:
     struct VisualHand
     {
         bool visible = false;
-        bool seeded = false;
         float visibility = 0.0f;
-        std::array<juce::Point<float>, 21> smoothed {};
+        std::array<juce::Point<float>, 21> landmarks {};
     };
 
     juce::Rectangle<float> getSceneBounds() const
@@ -387,7 +386,7 @@ private:
         std::array<juce::Point<float>, 21> mapped {};
 
         for (size_t i = 0; i < mapped.size(); ++i)
-            mapped[i] = mapPoint(scene, hand.smoothed[i]);
+            mapped[i] = mapPoint(scene, hand.landmarks[i]);
 
         return mapped;
     }
@@ -738,6 +737,152 @@ private:
     double timeSeconds = 0.0;
     float modulationEnergy = 0.0f;
     float reverseAmount = 0.0f;
+    juce::uint32 lastFrameSequence = 0;
+    bool wasPythonOn = false;
+};
+
+//Engine settings that have no place on the main page, shown in a call-out from the Engine
+//button. Every row reads the processor when the panel opens and writes straight back to it;
+//the values are saved with the plugin state and also reachable over OSC.
+class CMProjectAudioProcessorEditor::EngineSettingsComponent : public juce::Component
+{
+public:
+    explicit EngineSettingsComponent(CMProjectAudioProcessor& processorToUse)
+        : processor(processorToUse)
+    {
+        auto& window = addComboRow("Grain window", { "Hann", "Tukey", "Gaussian", "Trapezoid", "Exponential decay" },
+                                   processor.getWindowShape());
+        window.onChange = [this, &window] { processor.setWindowShape(window.getSelectedItemIndex()); };
+
+        auto& taper = addSliderRow("Window taper", 0.0, 1.0, 0.01, processor.getWindowTaper());
+        taper.onValueChange = [this, &taper] { processor.setWindowTaper((float)taper.getValue()); };
+
+        //Costs are measured on this machine shortly after the plugin loads
+        juce::StringArray interpolationNames;
+        const char* modeNames[] = { "Linear", "Hermite", "Sinc" };
+
+        for (int mode = 0; mode < CMProjectAudioProcessor::numInterpolationModes; ++mode)
+        {
+            const auto costNs = processor.getInterpolationCostNs(mode);
+            interpolationNames.add(juce::String(modeNames[mode])
+                                   + (costNs > 0.0f ? " (" + juce::String(costNs, 1) + " ns)" : juce::String()));
+        }
+
+        auto& live = addComboRow("Live interpolation", interpolationNames, processor.getInterpolationMode(false));
+        live.onChange = [this, &live] { processor.setInterpolationMode(live.getSelectedItemIndex(), false); };
+
+        auto& render = addComboRow("Render interpolation", interpolationNames, processor.getInterpolationMode(true));
+        render.onChange = [this, &render] { processor.setInterpolationMode(render.getSelectedItemIndex(), true); };
+
+        auto& filter = addComboRow("Cutoff filter", { "Voice (SVF)", "Per grain (one-pole)" },
+                                   processor.getGrainFilterMode());
+        filter.onChange = [this, &filter] { processor.setGrainFilterMode(filter.getSelectedItemIndex()); };
+
+        auto& steal = addComboRow("Voice stealing", { "Oldest voice", "Quietest voice" }, processor.getVoiceStealMode());
+        steal.onChange = [this, &steal] { processor.setVoiceStealMode(steal.getSelectedItemIndex()); };
+
+        //The pool is sized when the host prepares the plugin, so the range follows it
+        auto& budget = addSliderRow("Grain budget", 1.0, (double)juce::jmax(2, processor.getGrainPoolCapacity()), 1.0,
+                                    (double)processor.getGrainBudget(), " grains");
+        budget.onValueChange = [this, &budget] { processor.setGrainBudget((int)budget.getValue()); };
+
+        auto& latency = addSliderRow("Gesture latency", 0.0, 200.0, 1.0, processor.getGestureLatencyMs(), " ms");
+        latency.onValueChange = [this, &latency] { processor.setGestureLatencyMs((float)latency.getValue()); };
+
+        //Below zero the processor predicts as far as the audio lags the camera
+        auto& prediction = addSliderRow("Hand prediction", -1.0, CMProjectAudioProcessor::maxPredictionMs, 1.0,
+                                        processor.getLandmarkPredictionMs());
+        prediction.textFromValueFunction = [](double value) { return value < 0.0 ? juce::String("Auto") : juce::String(juce::roundToInt(value)) + " ms"; };
+        prediction.valueFromTextFunction = [](const juce::String& text) { return text.startsWithIgnoreCase("auto") ? -1.0 : text.getDoubleValue(); };
+        prediction.updateText();
+        prediction.onValueChange = [this, &prediction] { processor.setLandmarkPredictionMs((float)prediction.getValue()); };
+
+        for (int track = 0; track < 4; ++track)
+        {
+            juce::StringArray groups { "None" };
+
+            for (int group = 1; group <= CMProjectAudioProcessor::numDrumChokeGroups; ++group)
+                groups.add("Group " + juce::String(group));
+
+            auto& choke = addComboRow("Track " + juce::String(track + 1) + " choke", groups,
+                                      processor.getDrumChokeGroup(track));
+            choke.onChange = [this, track, &choke] { processor.setDrumChokeGroup(track, choke.getSelectedItemIndex()); };
+
+            //Shown in dB, the bottom of the range mutes the track
+            auto& volume = addSliderRow("Track " + juce::String(track + 1) + " volume", -60.0, 6.0, 0.1,
+                                        juce::Decibels::gainToDecibels(processor.getTrackVolume(track), -60.0f), " dB");
+            volume.onValueChange = [this, track, &volume]
+            {
+                processor.setTrackVolume(track, juce::Decibels::decibelsToGain((float)volume.getValue(), -60.0f));
+            };
+        }
+
+        setSize(340, rowHeight * (int)rows.size() + 2 * margin);
+    }
+
+    void paint(juce::Graphics& g) override
+    {
+        g.fillAll(juce::Colour::fromRGB(20, 20, 20));
+    }
+
+    void resized() override
+    {
+        auto area = getLocalBounds().reduced(margin);
+
+        for (auto& row : rows)
+        {
+            auto rowArea = area.removeFromTop(rowHeight).reduced(0, 3);
+            row.label->setBounds(rowArea.removeFromLeft(140));
+            row.control->setBounds(rowArea);
+        }
+    }
+
+private:
+    struct Row
+    {
+        std::unique_ptr<juce::Label> label;
+        std::unique_ptr<juce::Component> control;
+    };
+
+    juce::ComboBox& addComboRow(const juce::String& name, const juce::StringArray& items, int selectedIndex)
+    {
+        auto combo = std::make_unique<juce::ComboBox>(name);
+        combo->addItemList(items, 1);
+        combo->setSelectedItemIndex(selectedIndex, juce::dontSendNotification);
+
+        auto& result = *combo;
+        addRow(name, std::move(combo));
+        return result;
+    }
+
+    juce::Slider& addSliderRow(const juce::String& name, double minimum, double maximum, double interval,
+                               double value, const juce::String& suffix = {})
+    {
+        auto slider = std::make_unique<juce::Slider>(juce::Slider::LinearHorizontal, juce::Slider::TextBoxRight);
+        slider->setRange(minimum, maximum, interval);
+        slider->setValue(value, juce::dontSendNotification);
+        slider->setTextValueSuffix(suffix);
+        slider->setTextBoxStyle(juce::Slider::TextBoxRight, false, 64, 20);
+
+        auto& result = *slider;
+        addRow(name, std::move(slider));
+        return result;
+    }
+
+    void addRow(const juce::String& name, std::unique_ptr<juce::Component> control)
+    {
+        auto label = std::make_unique<juce::Label>(name, name);
+        label->setColour(juce::Label::textColourId, juce::Colours::lightgrey);
+        addAndMakeVisible(*label);
+        addAndMakeVisible(*control);
+        rows.push_back({ std::move(label), std::move(control) });
+    }
+
+    static constexpr int rowHeight = 30;
+    static constexpr int margin = 10;
+
+    CMProjectAudioProcessor& processor;
+    std::vector<Row> rows;
 };
 
 //borders of the plugin that light up periodically
@@ -933,10 +1078,11 @@ public:
     HDImageButton grainPos, grainDur, grainDensity, grainReverse, grainCutOff, grainPitch; //Hd images for granulator parameters
     juce::Image startImg, stopImg; //Start and Stop Images
     juce::Label granulatorTitle;
-    juce::File currentSampleFile, originalSampleFile; //Reversed- not reversed file
+    juce::File originalSampleFile; //The loaded file, never reversed on disk
     bool isReversed = false; //Boolean to handle when the sample is reversed or not
     float currentGrainPos = 0.0f; //Current grain position value
     float sampleDuration = 1.0f; //default, will be updated
+    float loadProgress = -1.0f; //0..1 while a sample is loading in the background
     juce::TextButton resetButton{ "Reset" }; //Button useful to reset all the default values
     
     //Constructor
@@ -1207,71 +1353,72 @@ public:
             g.setColour(juce::Colour::fromRGBA(0, 0, 0, 105));
             g.drawLine(waveformBounds.getX() + 6.0f, waveformBounds.getBottom() - 2.5f,
                        waveformBounds.getRight() - 6.0f, waveformBounds.getBottom() - 2.5f, 1.8f);
+
+            //Loading progress, while the sample is decoded in the background
+            if (loadProgress >= 0.0f)
+            {
+                auto barArea = waveformBounds.reduced(8.0f).removeFromBottom(4.0f);
+                g.setColour(juce::Colour::fromRGBA(0, 0, 0, 140));
+                g.fillRoundedRectangle(barArea, 2.0f);
+                g.setColour(juce::Colour::fromRGBA(74, 255, 128, 220));
+                g.fillRoundedRectangle(barArea.withWidth(barArea.getWidth() * loadProgress), 2.0f);
+
+                g.setColour(juce::Colours::white.withAlpha(0.85f));
+                g.setFont(juce::Font(14.0f));
+                g.drawText("Loading " + juce::String(juce::roundToInt(loadProgress * 100.0f)) + "%",
+                           waveformArea, juce::Justification::centred);
+            }
         }
     }
 
-    //function that reverses the sample
-    void reverseSample()
+    //Called from the editor timer. The waveform and the duration come from the audio the
+    //processor decoded, so a new file is only read once
+    void updateLoadedSample()
     {
-        if (!currentSampleFile.existsAsFile())
-            return;
+        loadProgress = processor.getSynthLoadProgress();
 
-        if (!isReversed)
+        auto decoded = processor.getDecodedSynthSample();
+        if (decoded != nullptr && decoded != shownSample && decoded->sampleRate > 0.0)
         {
-            //Read the original file
-            std::unique_ptr<juce::AudioFormatReader> reader(
-                formatManager.createReaderFor(originalSampleFile));
-            if (reader == nullptr) return;
-
-            auto numSamples = (int)reader->lengthInSamples; //check number of samples
-            auto numChannels = (int)reader->numChannels;    //check number of channels
-            juce::AudioBuffer<float> buffer(numChannels, numSamples);
-            reader->read(&buffer, 0, numSamples, 0, true, true); //read the buffer
-
-            //Reverse each channel in-place
-            for (int ch = 0; ch < numChannels; ++ch)
-                std::reverse(buffer.getWritePointer(ch),
-                    buffer.getWritePointer(ch) + numSamples);
-
-            //Write out a temp file
-            auto temp = juce::File::createTempFile(".wav");
-            if (auto* writer = formatManager
-                .findFormatForFileExtension("wav")
-                ->createWriterFor(new juce::FileOutputStream(temp),
-                    reader->sampleRate,
-                    (unsigned)numChannels,
-                    reader->bitsPerSample,
-                    {},
-                    0))
-            {
-                writer->writeFromAudioSampleBuffer(buffer, 0, numSamples);
-                delete writer;
-            }
-            else
-            {
-                jassertfalse;  //failed to create writer
-                return;
-            }
-
-            //Point thumbnail & OSC at the *temp*
-            thumbnail.setSource(new juce::FileInputSource(temp));
-            repaint();
-            processor.loadSynthSample(temp);
+            shownSample = decoded;
+            const auto& buffer = decoded->buffer;
+            thumbnail.reset(buffer.getNumChannels(), decoded->sampleRate, buffer.getNumSamples());
+            thumbnailSamplesAdded = 0;
 
-            //Update state
-            currentSampleFile = temp;
-            isReversed = true;
+            // Sample duration [s], for the grain position indicator
+            sampleDuration = (float)(buffer.getNumSamples() / decoded->sampleRate);
         }
-        else
-        {
-            //Simply restore the original
-            thumbnail.setSource(new juce::FileInputSource(originalSampleFile));
-            repaint();
-            processor.loadSynthSample(originalSampleFile);
 
-            currentSampleFile = originalSampleFile;
-            isReversed = false;
-        }
+        addThumbnailSlice();
+    }
+
+    //Scanning a long sample in one go would stall the message thread, so the waveform fills in
+    //a slice per timer tick (about a second for ten minutes of 48 kHz audio)
+    void addThumbnailSlice()
+    {
+        // A cleared thumbnail is waiting for the next decoded sample
+        if (shownSample == nullptr || thumbnail.getNumChannels() == 0)
+            return;
+
+        const auto& buffer = shownSample->buffer;
+        const auto numSamples = juce::jmin(thumbnailSliceSamples, buffer.getNumSamples() - thumbnailSamplesAdded);
+
+        if (numSamples <= 0)
+            return;
+
+        thumbnail.addBlock(thumbnailSamplesAdded, buffer, thumbnailSamplesAdded, numSamples);
+        thumbnailSamplesAdded += numSamples;
+    }
+
+    //function that reverses the sample: the processor decodes the original file again
+    //and reverses it on its background job, and the waveform follows in updateLoadedSample
+    void reverseSample()
+    {
+        if (!originalSampleFile.existsAsFile())
+            return;
+
+        isReversed = !isReversed;
+        processor.loadSynthSample(originalSampleFile, isReversed);
     }
 
     void resized() override
@@ -1449,9 +1596,9 @@ public:
         {
             DBG("→ Dropped file: " << droppedFile.getFullPathName());
 
-            processor.loadSynthSample(droppedFile);
+            processor.loadSynthSample(droppedFile); //decodes in the background, see updateLoadedSample
 
-            thumbnail.setSource(new juce::FileInputSource(droppedFile));
+            thumbnail.clear();
             repaint();
             startButton.setEnabled(true);
 
@@ -1460,7 +1607,6 @@ public:
             auto displayName = truncateWithEllipsis(fullName, 14);
             loadSampleButton.setButtonText(displayName);
             loadSampleButton.setTooltip(fullName);
-            currentSampleFile = droppedFile;
             isReversed = false;  //< reset reverse-state whenever a fresh file is loaded
             originalSampleFile = droppedFile;
         }
@@ -1472,6 +1618,9 @@ private:
     juce::AudioFormatManager formatManager;   // Used to recognize audio formats (.wav, .mp3, etc.)
     juce::AudioThumbnailCache thumbnailCache{ 5 }; // Caches thumbnails for efficiency (5 = number of items)
     juce::AudioThumbnail thumbnail{ 2048, formatManager, thumbnailCache }; // Main object to draw the waveform
+    std::shared_ptr<const CMProjectAudioProcessor::DecodedAudio> shownSample; // what the thumbnail shows
+    static constexpr int thumbnailSliceSamples = 1 << 19;
+    int thumbnailSamplesAdded = 0;
     StartCameraButtonLookAndFeel startCameraLookAndFeel;
     StopCameraButtonLookAndFeel stopCameraLookAndFeel;
     LoadButtonLookAndFeel loadButtonLookAndFeel;
@@ -1495,21 +1644,11 @@ private:
                 if (fileToLoad.existsAsFile())
                 {
                     DBG("→ Loading sample: " << fileToLoad.getFullPathName());
+                    //Decodes in the background; the waveform and duration follow in updateLoadedSample
                     processor.loadSynthSample(fileToLoad);
 
-                    // Send sample duration [s]
-                    double duration = 0.0;
-                    if (auto* reader = formatManager.createReaderFor(fileToLoad))
-                    {
-                        duration = reader->lengthInSamples / reader->sampleRate;
-                        processor.senderToPython.send("/sampleDuration", (float)duration);
-                        DBG("Sample duration: " << duration << " seconds");
-                        delete reader;
-                    }
-
-                    //Load a selected audio file into the thumbnail (for drawing the waveform)
-                    thumbnail.setSource(new juce::FileInputSource(fileToLoad));
-                    //Repaint the component to update the waveform after loading
+                    //Clear the old waveform until the new one is decoded
+                    thumbnail.clear();
                     repaint();
                     startButton.setEnabled(true); //Let the user play the sound
 
@@ -1518,7 +1657,6 @@ private:
                     auto displayName = truncateWithEllipsis(fullName, 14);
                     loadSampleButton.setButtonText(displayName);
                     loadSampleButton.setTooltip(fullName);
-                    currentSampleFile = fileToLoad;
                     originalSampleFile = fileToLoad;
                     isReversed = false;
                 }
@@ -1563,6 +1701,7 @@ CMProjectAudioProcessorEditor::CMProjectAudioProcessorEditor(CMProjectAudioProce
 {
     startingConfigurationGlobal(); //Function that handles the starting configuration
     clearFingersSetUp(); //Function that handles ClearFingers setup
+    engineSettingsSetUp(); //Function that handles the Engine settings button
     setToolTipFunction(); //Function that handles all the toolTip functions for both Synth and Drum page
     midiOnClickSetUpFunction(); //Function that handles all the oneclick setup functions
     pluginTitle(); //function that sets the plugin title
@@ -1607,6 +1746,7 @@ CMProjectAudioProcessorEditor::~CMProjectAudioProcessorEditor()
         middleButton.removeListener(this);
         ringButton.removeListener(this);
         pinkyButton.removeListener(this);
+        engineSettingsButton.removeListener(this);
         clearLookAndFeelRecursively (this);
         
         delete synthPage;
@@ -1674,6 +1814,12 @@ void CMProjectAudioProcessorEditor::clearFingersSetUp() {
     clearFingersButton.setLookAndFeel(&clearFingerButtonLookAndFeel);
     clearFingersButton.setVisible(false);
 }
+void CMProjectAudioProcessorEditor::engineSettingsSetUp() {
+    addAndMakeVisible(engineSettingsButton);
+    engineSettingsButton.addListener(this);
+    engineSettingsButton.setLookAndFeel(&engineSettingsButtonLookAndFeel);
+    engineSettingsButton.setTooltip("Engine settings: grain window, interpolation, filter, voices, hand latency and drum tracks");
+}
 void CMProjectAudioProcessorEditor::midiOnClickSetUpFunction() {
     synthPage->recordAudioButton.onClick = [this]()
         {
@@ -1849,7 +1995,7 @@ void CMProjectAudioProcessorEditor::paint(juce::Graphics&) {}
 void CMProjectAudioProcessorEditor::paintOverChildren(juce::Graphics& g)
 {
     const auto timeSeconds = juce::Time::getMillisecondCounterHiRes() * 0.001;
-    const auto trackedHands = audioProcessor.getTrackedHands();
+    const auto& trackedHands = audioProcessor.getLatestHandFrame().hands;
     const auto* mappedHand = trackedHands[1].visible ? &trackedHands[1]
                                                      : (trackedHands[0].visible ? &trackedHands[0] : nullptr);
 
@@ -2074,6 +2220,9 @@ void CMProjectAudioProcessorEditor::resized()
     statusDisplay.setBounds({});
     clearFingersButton.setBounds({});
 
+    //Engine settings button in the strip under the visualizer
+    engineSettingsButton.setBounds(getWidth() / 2 - scaled(60), scaled(685), scaled(120), scaled(34));
+
     // Plugin title perfectly centered at top
     auto textWidth = pageTitleLabel.getFont().getStringWidth("HAND GRANULATOR");
     const int totalWidth = textWidth + scaled(20);
@@ -2117,9 +2266,7 @@ juce::Colour CMProjectAudioProcessorEditor::getParameterAccentColour(const juce:
 
 bool CMProjectAudioProcessorEditor::hasVisibleTrackedHands() const
 {
-    const auto trackedHands = audioProcessor.getTrackedHands();
-
-    for (const auto& hand : trackedHands)
+    for (const auto& hand : audioProcessor.getLatestHandFrame().hands)
         if (hand.visible)
             return true;
 
@@ -2266,7 +2413,7 @@ bool CMProjectAudioProcessorEditor::assignParameterToFinger(const juce::String&
         }
     }
 
-    audioProcessor.senderToPython.send("/activePage", currentPage);
+    audioProcessor.sendActivePageOSC(currentPage);
     audioProcessor.fingerControls[fingerIndex] = parameter;
     audioProcessor.sendFingerAssignementsOSC();
 
@@ -2323,7 +2470,7 @@ void CMProjectAudioProcessorEditor::buttonClicked(juce::Button* button)
             return;
         }
 
-        audioProcessor.senderToPython.send("/resetParameters");
+        audioProcessor.resetGestureParameters();
         statusDisplay.showMessage("Resetting parameters!");
         return;
     }
@@ -2413,6 +2560,11 @@ void CMProjectAudioProcessorEditor::buttonClicked(juce::Button* button)
     {
         assignParameterToFinger(currentParameter, currentParameterIcon, pinkyButton);
     }
+    else if (button == &engineSettingsButton)
+    {
+        juce::CallOutBox::launchAsynchronously(std::make_unique<EngineSettingsComponent>(audioProcessor),
+                                               engineSettingsButton.getBounds(), this);
+    }
     else if (button == &clearFingersButton)
     {
         if (!isPythonOn)
@@ -2495,11 +2647,19 @@ bool CMProjectAudioProcessorEditor::launchPythonHandTracker()
     
     if (pythonProcess.isRunning())
         return true;
+
+    // Offer the tracker shared memory for hand frames and settings; it falls back to UDP
+    // on its own if it can't attach.
+    const auto sharedMemoryName = audioProcessor.openSharedGestureTransport();
+
+    if (sharedMemoryName.isNotEmpty())
+        cmd.addArray({ "--shm", sharedMemoryName });
         
     DBG("Launching: " << cmd.joinIntoString(" "));
 
     if (! pythonProcess.start(cmd))
     {
+        audioProcessor.closeSharedGestureTransport();
         DBG("❌ Couldn’t launch Python hand-tracker");
         statusDisplay.showMessage("Could not launch tracker");
         return false;
@@ -2509,6 +2669,7 @@ bool CMProjectAudioProcessorEditor::launchPythonHandTracker()
 
     if (! pythonProcess.isRunning())
     {
+        audioProcessor.closeSharedGestureTransport();
         auto output = pythonProcess.readAllProcessOutput().trim();
         DBG("❌ Python tracker exited early. Output: " << output);
         statusDisplay.showMessage(output.isNotEmpty() ? output : "Camera failed to start");
@@ -2522,7 +2683,7 @@ bool CMProjectAudioProcessorEditor::launchPythonHandTracker()
         {
             cameraRunning = true;
             isPythonOn = true;
-            audioProcessor.senderToPython.send("/activePage", currentPage);
+            audioProcessor.sendActivePageOSC(currentPage);
             return true;
         }
 
@@ -2543,6 +2704,7 @@ bool CMProjectAudioProcessorEditor::launchPythonHandTracker()
 
     cameraRunning = false;
     isPythonOn = false;
+    audioProcessor.closeSharedGestureTransport();
     statusDisplay.showMessage(output.isNotEmpty() ? output : "Tracker did not start");
     return false;
 }
@@ -2560,6 +2722,7 @@ void CMProjectAudioProcessorEditor::stopPythonHandTracker()
     }
     cameraRunning = false;
     isPythonOn = false;
+    audioProcessor.closeSharedGestureTransport();
     audioProcessor.clearTrackedHands();
 
     if (handVisualizer)
@@ -2572,12 +2735,21 @@ void CMProjectAudioProcessorEditor::timerCallback()
     if (synthPage)
     {
         synthPage->currentGrainPos = audioProcessor.getGrainPos();
+        synthPage->updateLoadedSample();
     }
 
     if (handVisualizer)
         handVisualizer->tick(juce::Time::getMillisecondCounterHiRes() * 0.001);
 
-    updateFingerTargetVisibility();
+    // User actions update the targets themselves; the timer only has to follow the hands
+    const auto handFrameSequence = audioProcessor.getLatestHandFrame().sequence;
+
+    if (handFrameSequence != lastHandFrameSequence)
+    {
+        lastHandFrameSequence = handFrameSequence;
+        updateFingerTargetVisibility();
+    }
+
     synthPage->repaint(); //force waveform + bar to redraw
 
     if (isParameterDragActive)
@@ -2590,6 +2762,7 @@ void CMProjectAudioProcessorEditor::timerCallback()
         synthPage->startCamera.setEnabled(true);
         synthPage->stopCamera.setEnabled(false);
         isPythonOn = false;
+        audioProcessor.closeSharedGestureTransport();
         audioProcessor.clearTrackedHands();
 
         auto output = pythonProcess.readAllProcessOutput().trim();
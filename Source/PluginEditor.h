@@ -102,15 +102,19 @@ public:
     void pluginTitle();
     void midiOnClickSetUpFunction();
     void clearFingersSetUp();
+    void engineSettingsSetUp();
     void startingConfigurationGlobal();
     void addListenerToGLobal();
     juce::TextButton clearFingersButton{ "Clear Fingers" };
+    juce::TextButton engineSettingsButton{ "Engine" };
    
 private:
 
     class SynthPageComponent;
     class HandVisualizerComponent;
+    class EngineSettingsComponent;
     LoadButtonLookAndFeel clearFingerButtonLookAndFeel;
+    LoadButtonLookAndFeel engineSettingsButtonLookAndFeel;
     std::unique_ptr<GridBackgroundComponent> background;
     std::unique_ptr<HandVisualizerComponent> handVisualizer;
     CMProjectAudioProcessor& audioProcessor;
@@ -289,6 +293,7 @@ private:
     void clearFingerAssignmentVisuals(int fingerIndex);
     bool hasVisibleTrackedHands() const;
     void updateFingerTargetVisibility();
+    juce::uint32 lastHandFrameSequence = 0;
     void updateFingerDragHover(juce::Point<float> screenPosition);
     void beginParameterDrag(const juce::String& parameter,
                             const juce::Image& icon,
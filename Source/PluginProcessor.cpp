@@ -9,6 +9,349 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 #include <cmath>
+#include <limits>
+
+#if (JUCE_MAC || JUCE_LINUX) && JUCE_INTEL
+ #include <fcntl.h>
+ #include <sys/mman.h>
+ #include <unistd.h>
+#endif
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+ #if JUCE_GCC || JUCE_CLANG
+  #define GRAIN_KERNEL_SSE2 __attribute__ ((target ("sse2")))
+  #define GRAIN_KERNEL_AVX2 __attribute__ ((target ("avx2")))
+ #else
+  #define GRAIN_KERNEL_SSE2
+  #define GRAIN_KERNEL_AVX2
+ #endif
+#endif
+
+namespace
+{
+    constexpr int maxGrainLanes = 8;
+    constexpr int maxLaneChannels = CMProjectAudioProcessor::maxRenderChannels;
+
+    // Lane-major copy of up to eight grains that sound for the whole block. The read position
+    // is split into an integer index and a float fraction so it fits 32-bit SIMD lanes. Indices
+    // address the whole pyramid buffer, so each lane carries the bounds of its own level.
+    struct GrainLanes
+    {
+        alignas (32) int index[maxGrainLanes];
+        alignas (32) int firstIndex[maxGrainLanes];
+        alignas (32) int lastIndex[maxGrainLanes];
+        alignas (32) float frac[maxGrainLanes];
+        alignas (32) int stepInt[maxGrainLanes];
+        alignas (32) float stepFrac[maxGrainLanes];
+        alignas (32) int windowOffset[maxGrainLanes];
+        alignas (32) juce::uint32 windowPhase[maxGrainLanes];
+        alignas (32) juce::uint32 windowPhaseInc[maxGrainLanes];
+        alignas (32) float gain[maxGrainLanes];
+        alignas (32) float lowpass[maxLaneChannels][maxGrainLanes];
+    };
+
+    struct GrainKernelArgs
+    {
+        const float* const* sources = nullptr; // one pointer per output channel
+        float* const* outputs = nullptr;
+        int numOutputs = 0;
+        int numSamples = 0;
+        float lowpassAlpha = 1.0f; // 1 bypasses the per-grain filter
+        const float* windows = nullptr;
+    };
+
+    constexpr int windowFracBits = CMProjectAudioProcessor::GrainWindowBank::fracBits;
+    constexpr float windowFracScale = 1.0f / (float) (1u << windowFracBits);
+
+    inline float readWindow (const float* windows, int offset, juce::uint32 phase) noexcept
+    {
+        const auto* table = windows + offset + (int) (phase >> windowFracBits);
+        const float frac = (float) (phase & ((1u << windowFracBits) - 1u)) * windowFracScale;
+        return table[0] + (table[1] - table[0]) * frac;
+    }
+
+    // Per-grain state copied out of the pool for the duration of one span.
+    struct GrainSpan
+    {
+        double samplePos = 0.0;
+        double sampleStep = 0.0;
+        float gain = 0.0f;
+        float lowpass[maxLaneChannels] {};
+        const float* window = nullptr;
+        juce::uint32 windowPhase = 0;
+        juce::uint32 windowPhaseInc = 0;
+    };
+
+    // Interpolators split into prepare(), run once per output sample, and read(), run once
+    // per channel, so multichannel grains only compute their weights once.
+    struct LinearInterpolator
+    {
+        using Weights = float;
+
+        Weights prepare (float frac) const noexcept { return frac; }
+
+        float read (const float* src, int index, Weights frac, int) const noexcept
+        {
+            return src[index] + (src[index + 1] - src[index]) * frac;
+        }
+    };
+
+    // 4-point, 3rd-order Hermite (Catmull-Rom).
+    struct HermiteInterpolator
+    {
+        using Weights = float;
+
+        Weights prepare (float frac) const noexcept { return frac; }
+
+        float read (const float* src, int index, Weights frac, int length) const noexcept
+        {
+            const float xm1 = src[index > 0 ? index - 1 : 0];
+            const float x0 = src[index];
+            const float x1 = src[index + 1];
+            const float x2 = src[index + 2 < length ? index + 2 : length - 1];
+
+            const float c1 = 0.5f * (x1 - xm1);
+            const float c2 = xm1 - 2.5f * x0 + 2.0f * x1 - 0.5f * x2;
+            const float c3 = 0.5f * (x2 - xm1) + 1.5f * (x0 - x1);
+            return ((c3 * frac + c2) * frac + c1) * frac + x0;
+        }
+    };
+
+    struct SincInterpolator
+    {
+        using Table = CMProjectAudioProcessor::PolyphaseSincTable;
+        static constexpr int numTaps = Table::numTaps;
+        static constexpr int leftTaps = numTaps / 2 - 1;
+
+        struct Weights { float taps[numTaps]; };
+
+        const float* table = nullptr;
+
+        Weights prepare (float frac) const noexcept
+        {
+            const float position = frac * (float) Table::numPhases;
+            const int phase = juce::jlimit (0, Table::numPhases - 1, (int) position);
+            const float phaseFrac = position - (float) phase;
+            const float* coeffs = table + phase * Table::phaseStride;
+            const float* deltas = coeffs + numTaps;
+
+            Weights weights;
+
+            for (int k = 0; k < numTaps; ++k)
+                weights.taps[k] = coeffs[k] + deltas[k] * phaseFrac;
+
+            return weights;
+        }
+
+        float read (const float* src, int index, const Weights& weights, int length) const noexcept
+        {
+            const int first = index - leftTaps;
+            float sum = 0.0f;
+
+            if (first >= 0 && first + numTaps <= length)
+            {
+                for (int k = 0; k < numTaps; ++k)
+                    sum += src[first + k] * weights.taps[k];
+            }
+            else
+            {
+                for (int k = 0; k < numTaps; ++k)
+                    sum += src[juce::jlimit (0, length - 1, first + k)] * weights.taps[k];
+            }
+
+            return sum;
+        }
+    };
+
+    // Scalar reference renderer for one grain over [startSample, startSample + numToRender).
+    // The caller has already clipped the span so the read position stays inside the source.
+    // A lowpassAlpha below 1 runs the optional per-grain one-pole, with its own state per channel.
+    template <typename Interpolator>
+    void renderGrainSpan (GrainSpan& grain, const Interpolator& interpolator,
+                          const float* const* sources, float* const* outputs, int numOutputs,
+                          int startSample, int numToRender, int sourceLength, float lowpassAlpha) noexcept
+    {
+        const int lastPairIndex = juce::jmax (0, sourceLength - 2);
+        const bool filtered = lowpassAlpha < 1.0f;
+        double samplePos = grain.samplePos;
+        float* lowpass = grain.lowpass;
+        juce::uint32 windowPhase = grain.windowPhase;
+        const int endSample = startSample + numToRender;
+
+        for (int i = startSample; i < endSample; ++i)
+        {
+            const int idx0 = juce::jmin ((int) samplePos, lastPairIndex);
+            const auto weights = interpolator.prepare ((float) (samplePos - (double) idx0));
+            const float amp = grain.gain * readWindow (grain.window, 0, windowPhase);
+
+            for (int ch = 0; ch < numOutputs; ++ch)
+            {
+                const float raw = interpolator.read (sources[ch], idx0, weights, sourceLength) * amp;
+
+                if (filtered)
+                {
+                    lowpass[ch] += lowpassAlpha * (raw - lowpass[ch]);
+                    outputs[ch][i] += lowpass[ch];
+                }
+                else
+                {
+                    outputs[ch][i] += raw;
+                }
+            }
+
+            samplePos += grain.sampleStep;
+            windowPhase += grain.windowPhaseInc;
+        }
+
+        grain.samplePos = samplePos;
+        grain.windowPhase = windowPhase;
+    }
+
+   #if JUCE_INTEL
+    GRAIN_KERNEL_SSE2 static inline float horizontalSum (__m128 v) noexcept
+    {
+        auto shuffled = _mm_shuffle_ps (v, v, _MM_SHUFFLE (2, 3, 0, 1));
+        auto sums = _mm_add_ps (v, shuffled);
+        shuffled = _mm_movehl_ps (shuffled, sums);
+        return _mm_cvtss_f32 (_mm_add_ss (sums, shuffled));
+    }
+
+    GRAIN_KERNEL_SSE2 static inline __m128i clampIndex (__m128i index, __m128i firstIndex, __m128i lastIndex) noexcept
+    {
+        const auto tooHigh = _mm_cmpgt_epi32 (index, lastIndex);
+        index = _mm_or_si128 (_mm_andnot_si128 (tooHigh, index), _mm_and_si128 (tooHigh, lastIndex));
+        const auto tooLow = _mm_cmplt_epi32 (index, firstIndex);
+        return _mm_or_si128 (_mm_andnot_si128 (tooLow, index), _mm_and_si128 (tooLow, firstIndex));
+    }
+
+    // Four grains per iteration. SSE2 has no gather, so the taps are loaded through a lane array.
+    GRAIN_KERNEL_SSE2 static void renderGrainLanesSSE2 (GrainLanes& lanes, const GrainKernelArgs& args) noexcept
+    {
+        const auto one = _mm_set1_ps (1.0f);
+        const auto alpha = _mm_set1_ps (args.lowpassAlpha);
+        const auto firstIndex = _mm_load_si128 ((const __m128i*) lanes.firstIndex);
+        const auto lastIndex = _mm_load_si128 ((const __m128i*) lanes.lastIndex);
+
+        auto index = _mm_load_si128 ((const __m128i*) lanes.index);
+        auto frac = _mm_load_ps (lanes.frac);
+        const auto stepInt = _mm_load_si128 ((const __m128i*) lanes.stepInt);
+        const auto stepFrac = _mm_load_ps (lanes.stepFrac);
+        auto windowPhase = _mm_load_si128 ((const __m128i*) lanes.windowPhase);
+        const auto windowPhaseInc = _mm_load_si128 ((const __m128i*) lanes.windowPhaseInc);
+        const auto gain = _mm_load_ps (lanes.gain);
+        const bool filtered = args.lowpassAlpha < 1.0f;
+        __m128 lowpass[maxLaneChannels];
+
+        for (int ch = 0; ch < args.numOutputs; ++ch)
+            lowpass[ch] = _mm_load_ps (lanes.lowpass[ch]);
+
+        alignas (16) int taps[4];
+        alignas (16) juce::uint32 phases[4];
+
+        for (int i = 0; i < args.numSamples; ++i)
+        {
+            _mm_store_si128 ((__m128i*) taps, clampIndex (index, firstIndex, lastIndex));
+            _mm_store_si128 ((__m128i*) phases, windowPhase);
+
+            const auto window = _mm_setr_ps (readWindow (args.windows, lanes.windowOffset[0], phases[0]),
+                                             readWindow (args.windows, lanes.windowOffset[1], phases[1]),
+                                             readWindow (args.windows, lanes.windowOffset[2], phases[2]),
+                                             readWindow (args.windows, lanes.windowOffset[3], phases[3]));
+            const auto amp = _mm_mul_ps (gain, window);
+
+            for (int ch = 0; ch < args.numOutputs; ++ch)
+            {
+                const auto* src = args.sources[ch];
+                const auto s0 = _mm_setr_ps (src[taps[0]], src[taps[1]], src[taps[2]], src[taps[3]]);
+                const auto s1 = _mm_setr_ps (src[taps[0] + 1], src[taps[1] + 1], src[taps[2] + 1], src[taps[3] + 1]);
+                const auto raw = _mm_mul_ps (_mm_add_ps (s0, _mm_mul_ps (_mm_sub_ps (s1, s0), frac)), amp);
+
+                if (filtered)
+                {
+                    lowpass[ch] = _mm_add_ps (lowpass[ch], _mm_mul_ps (alpha, _mm_sub_ps (raw, lowpass[ch])));
+                    args.outputs[ch][i] += horizontalSum (lowpass[ch]);
+                }
+                else
+                {
+                    args.outputs[ch][i] += horizontalSum (raw);
+                }
+            }
+
+            frac = _mm_add_ps (frac, stepFrac);
+            const auto carry = _mm_cmpge_ps (frac, one);
+            frac = _mm_sub_ps (frac, _mm_and_ps (carry, one));
+            index = _mm_sub_epi32 (_mm_add_epi32 (index, stepInt), _mm_castps_si128 (carry));
+            windowPhase = _mm_add_epi32 (windowPhase, windowPhaseInc);
+        }
+
+        for (int ch = 0; ch < args.numOutputs; ++ch)
+            _mm_store_ps (lanes.lowpass[ch], lowpass[ch]);
+    }
+
+    // Eight grains per iteration with hardware gathers for the interpolation taps.
+    GRAIN_KERNEL_AVX2 static void renderGrainLanesAVX2 (GrainLanes& lanes, const GrainKernelArgs& args) noexcept
+    {
+        const auto one = _mm256_set1_ps (1.0f);
+        const auto alpha = _mm256_set1_ps (args.lowpassAlpha);
+        const auto fracMask = _mm256_set1_epi32 ((int) ((1u << windowFracBits) - 1u));
+        const auto fracScale = _mm256_set1_ps (windowFracScale);
+        const auto firstIndex = _mm256_load_si256 ((const __m256i*) lanes.firstIndex);
+        const auto lastIndex = _mm256_load_si256 ((const __m256i*) lanes.lastIndex);
+
+        auto index = _mm256_load_si256 ((const __m256i*) lanes.index);
+        auto frac = _mm256_load_ps (lanes.frac);
+        const auto stepInt = _mm256_load_si256 ((const __m256i*) lanes.stepInt);
+        const auto stepFrac = _mm256_load_ps (lanes.stepFrac);
+        const auto windowOffset = _mm256_load_si256 ((const __m256i*) lanes.windowOffset);
+        auto windowPhase = _mm256_load_si256 ((const __m256i*) lanes.windowPhase);
+        const auto windowPhaseInc = _mm256_load_si256 ((const __m256i*) lanes.windowPhaseInc);
+        const auto gain = _mm256_load_ps (lanes.gain);
+        const bool filtered = args.lowpassAlpha < 1.0f;
+        __m256 lowpass[maxLaneChannels];
+
+        for (int ch = 0; ch < args.numOutputs; ++ch)
+            lowpass[ch] = _mm256_load_ps (lanes.lowpass[ch]);
+
+        for (int i = 0; i < args.numSamples; ++i)
+        {
+            const auto taps = _mm256_max_epi32 (firstIndex, _mm256_min_epi32 (index, lastIndex));
+
+            const auto windowIndex = _mm256_add_epi32 (windowOffset, _mm256_srli_epi32 (windowPhase, windowFracBits));
+            const auto windowFrac = _mm256_mul_ps (_mm256_cvtepi32_ps (_mm256_and_si256 (windowPhase, fracMask)), fracScale);
+            const auto w0 = _mm256_i32gather_ps (args.windows, windowIndex, 4);
+            const auto w1 = _mm256_i32gather_ps (args.windows + 1, windowIndex, 4);
+            const auto amp = _mm256_mul_ps (gain, _mm256_add_ps (w0, _mm256_mul_ps (_mm256_sub_ps (w1, w0), windowFrac)));
+
+            for (int ch = 0; ch < args.numOutputs; ++ch)
+            {
+                const auto* src = args.sources[ch];
+                const auto s0 = _mm256_i32gather_ps (src, taps, 4);
+                const auto s1 = _mm256_i32gather_ps (src + 1, taps, 4);
+                auto sum = _mm256_mul_ps (_mm256_add_ps (s0, _mm256_mul_ps (_mm256_sub_ps (s1, s0), frac)), amp);
+
+                if (filtered)
+                {
+                    lowpass[ch] = _mm256_add_ps (lowpass[ch], _mm256_mul_ps (alpha, _mm256_sub_ps (sum, lowpass[ch])));
+                    sum = lowpass[ch];
+                }
+
+                const auto folded = _mm_add_ps (_mm256_castps256_ps128 (sum), _mm256_extractf128_ps (sum, 1));
+                args.outputs[ch][i] += horizontalSum (folded);
+            }
+
+            frac = _mm256_add_ps (frac, stepFrac);
+            const auto carry = _mm256_cmp_ps (frac, one, _CMP_GE_OQ);
+            frac = _mm256_sub_ps (frac, _mm256_and_ps (carry, one));
+            index = _mm256_sub_epi32 (_mm256_add_epi32 (index, stepInt), _mm256_castps_si256 (carry));
+            windowPhase = _mm256_add_epi32 (windowPhase, windowPhaseInc);
+        }
+
+        for (int ch = 0; ch < args.numOutputs; ++ch)
+            _mm256_store_ps (lanes.lowpass[ch], lowpass[ch]);
+    }
+   #endif
+}
 
 //==============================================================================
 CMProjectAudioProcessor::CMProjectAudioProcessor()
@@ -25,14 +368,46 @@ CMProjectAudioProcessor::CMProjectAudioProcessor()
 
 {
     formatManager.registerBasicFormats();
+    grainWindows.build();
+    sincTable.build();
+    rateConverter.build();
+    gestureCurve.build();
     audioRecordingThread.startThread();
+    releasePoolThread.addTimeSliceClient(&releasePool);
+    releasePoolThread.startThread();
     updateParameters();
+
+    for (auto* address : { "/handGrain", "/handState", "/handFrame", "/triggerDrum",
+                           "/sequencerStep", "/sequencerPattern", "/sequencerRunning", "/drumChokeGroup",
+                           "/drumVolume", "/windowShape", "/windowTaper", "/grainFilterMode", "/voiceStealMode",
+                           "/grainBudget", "/interpolationMode", "/gestureLatency", "/landmarkPrediction" })
+        oscReceiver.addListener(this, address);
+
+    // Only reads the immutable tables built above and stores atomics, so it can run while
+    // the host prepares and plays.
+    conversionPool.addJob([this] { measureInterpolationCosts(); });
 }
 
 CMProjectAudioProcessor::~CMProjectAudioProcessor()
 {
+    closeSharedGestureTransport();
+    sharedTransportThread.stopThread(2000);
+
+    // Stop the receiver thread calling in before anything it touches goes away; only then is
+    // the listener list safe to change.
+    oscReceiver.disconnect();
+    oscReceiver.removeListener(this);
+
+    // Conversions still running see their generation move on, skip their remaining blocks
+    // and publish nothing.
+    for (auto& generation : conversionGenerations)
+        ++generation;
+    conversionPool.removeAllJobs(true, 10000);
+
     stopAudioRecording();
     audioRecordingThread.stopThread(2000);
+    releasePoolThread.removeTimeSliceClient(&releasePool);
+    releasePoolThread.stopThread(2000);
 }
 
 //==============================================================================
@@ -52,6 +427,14 @@ bool CMProjectAudioProcessor::acceptsMidi() const
 
 //function that handles the fingers assignement in the synth page
 void CMProjectAudioProcessor::sendFingerAssignementsOSC() {
+    for (size_t i = 0; i < fingerParameterIds.size(); ++i)
+        fingerParameterIds[i].store(getFingerParameterId(fingerControls[i]));
+
+    sharedTransport.writeControls(fingerControls, fingerDrumMapping, activePage);
+
+    if (sharedTransport.isTrackerAttached())
+        return;
+
     senderToPython.send("/fingerParameters", fingerControls[0],
         fingerControls[1],
         fingerControls[2],
@@ -66,6 +449,11 @@ void CMProjectAudioProcessor::sendFingerDrumMappingOSC()
             return s.isNotEmpty() ? s.getIntValue() : -1;
         };
 
+    sharedTransport.writeControls(fingerControls, fingerDrumMapping, activePage);
+
+    if (sharedTransport.isTrackerAttached())
+        return;
+
     senderToPython.send("/fingerDrums",
         toInt(fingerDrumMapping[0]),
         toInt(fingerDrumMapping[1]),
@@ -73,6 +461,188 @@ void CMProjectAudioProcessor::sendFingerDrumMappingOSC()
         toInt(fingerDrumMapping[3]));
 }
 
+void CMProjectAudioProcessor::sendActivePageOSC(const juce::String& page)
+{
+    activePage = page;
+    synthPageActive.store(page == "synth");
+    sharedTransport.writeControls(fingerControls, fingerDrumMapping, activePage);
+
+    if (! sharedTransport.isTrackerAttached())
+        senderToPython.send("/activePage", page);
+}
+
+juce::String CMProjectAudioProcessor::openSharedGestureTransport()
+{
+    closeSharedGestureTransport();
+
+    if (! sharedTransport.open())
+        return {};
+
+    // The tracker picks the settings up from the mailbox as soon as it attaches
+    sharedTransport.writeControls(fingerControls, fingerDrumMapping, activePage);
+    sharedHandFramesAttached.store(true);
+    sharedTransportThread.addTimeSliceClient(&sharedTransport);
+
+    if (! sharedTransportThread.isThreadRunning())
+        sharedTransportThread.startThread();
+
+    return sharedTransport.getName();
+}
+
+void CMProjectAudioProcessor::closeSharedGestureTransport()
+{
+    sharedTransportThread.removeTimeSliceClient(&sharedTransport); // waits for a running read
+    sharedHandFramesAttached.store(false);
+    sharedTransport.close();
+}
+
+// The tracker writes its side with plain struct.pack_into stores, which carry no memory
+// fences. x86 keeps stores in program order, so the seqlocks hold there; on arm64 the reader
+// could see a slot's sequence before its frame, so the link stays on UDP everywhere else.
+#if (JUCE_MAC || JUCE_LINUX) && JUCE_INTEL
+// Layout shared with main.py, which addresses it by byte offset. Sequence fields work as
+// seqlocks: odd while the owner is writing, bumped to the next even value when done.
+struct CMProjectAudioProcessor::SharedGestureTransport::Region
+{
+    static constexpr juce::uint32 magic = 0x4d534748; // "HGSM"
+    static constexpr juce::uint32 version = 1;
+    static constexpr int numSlots = 16;
+
+    struct Slot
+    {
+        std::atomic<juce::uint32> sequence;
+        juce::uint8 frame[handFrameBytes];
+    };
+
+    juce::uint32 magicNumber;
+    juce::uint32 layoutVersion;
+    std::atomic<juce::uint32> trackerPid;      // set by the tracker once it has attached
+    std::atomic<juce::uint32> framesWritten;   // bumped by the tracker after each complete slot
+    Slot slots[numSlots];
+
+    // Mailbox, written by the plugin
+    std::atomic<juce::uint32> controlSequence;
+    juce::int32 fingerDrums[4];                // -1 for no track
+    char fingerParameters[4][32];              // null-terminated parameter names
+    char activePage[16];
+};
+
+bool CMProjectAudioProcessor::SharedGestureTransport::open()
+{
+    static_assert(sizeof(std::atomic<juce::uint32>) == 4, "the tracker expects 32-bit sequence fields");
+    static_assert(sizeof(Region) == 16 + Region::numSlots * (4 + handFrameBytes) + 164,
+                  "shared layout changed; update main.py to match");
+    static std::atomic<int> regionCounter { 0 };
+
+    close();
+    name = "hg-" + juce::String((int)getpid()) + "-" + juce::String(++regionCounter);
+    const auto path = "/" + name;
+    const int fd = shm_open(path.toRawUTF8(), O_CREAT | O_EXCL | O_RDWR, 0600);
+
+    if (fd < 0)
+    {
+        DBG("Could not create shared memory " << path << ", using UDP");
+        name = {};
+        return false;
+    }
+
+    void* memory = MAP_FAILED;
+
+    if (ftruncate(fd, (off_t)sizeof(Region)) == 0)
+        memory = mmap(nullptr, sizeof(Region), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    ::close(fd);
+
+    if (memory == MAP_FAILED)
+    {
+        DBG("Could not map shared memory " << path << ", using UDP");
+        shm_unlink(path.toRawUTF8());
+        name = {};
+        return false;
+    }
+
+    // ftruncate zero-fills the new region, which is the empty state of every field
+    region = static_cast<Region*>(memory);
+    region->magicNumber = Region::magic;
+    region->layoutVersion = Region::version;
+    framesRead = 0;
+    return true;
+}
+
+void CMProjectAudioProcessor::SharedGestureTransport::close()
+{
+    if (region == nullptr)
+        return;
+
+    munmap(region, sizeof(Region));
+    shm_unlink(("/" + name).toRawUTF8());
+    region = nullptr;
+    name = {};
+}
+
+bool CMProjectAudioProcessor::SharedGestureTransport::isTrackerAttached() const noexcept
+{
+    return region != nullptr && region->trackerPid.load(std::memory_order_acquire) != 0;
+}
+
+// Message thread only
+void CMProjectAudioProcessor::SharedGestureTransport::writeControls(const juce::String (&fingerParameters)[4],
+                                                                    const juce::String (&fingerDrums)[4],
+                                                                    const juce::String& page)
+{
+    if (region == nullptr)
+        return;
+
+    const auto sequence = region->controlSequence.load(std::memory_order_relaxed);
+    region->controlSequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (int i = 0; i < 4; ++i)
+    {
+        region->fingerDrums[i] = fingerDrums[i].isNotEmpty() ? fingerDrums[i].getIntValue() : -1;
+        fingerParameters[i].copyToUTF8(region->fingerParameters[i], sizeof(region->fingerParameters[i]));
+    }
+
+    page.copyToUTF8(region->activePage, sizeof(region->activePage));
+    region->controlSequence.store(sequence + 2, std::memory_order_release);
+}
+
+// Only the newest frame matters, so the reader skips straight to it instead of draining the ring
+int CMProjectAudioProcessor::SharedGestureTransport::useTimeSlice()
+{
+    if (region == nullptr)
+        return 100;
+
+    const auto written = region->framesWritten.load(std::memory_order_acquire);
+
+    if (written == framesRead)
+        return 2;
+
+    auto& slot = region->slots[(written - 1) % Region::numSlots];
+    const auto before = slot.sequence.load(std::memory_order_acquire);
+
+    if ((before & 1) != 0)
+        return 0; // being rewritten after the tracker lapped us; try again right away
+
+    juce::uint8 frame[handFrameBytes];
+    std::memcpy(frame, slot.frame, sizeof(frame));
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    if (slot.sequence.load(std::memory_order_relaxed) != before)
+        return 0;
+
+    framesRead = written;
+    processor.handleHandFrame(frame, sizeof(frame), GestureClock::nowMicros(), false);
+    return 2;
+}
+#else
+bool CMProjectAudioProcessor::SharedGestureTransport::open() { return false; }
+void CMProjectAudioProcessor::SharedGestureTransport::close() {}
+bool CMProjectAudioProcessor::SharedGestureTransport::isTrackerAttached() const noexcept { return false; }
+void CMProjectAudioProcessor::SharedGestureTransport::writeControls(const juce::String (&)[4], const juce::String (&)[4], const juce::String&) {}
+int CMProjectAudioProcessor::SharedGestureTransport::useTimeSlice() { return 100; }
+#endif
+
 bool CMProjectAudioProcessor::producesMidi() const
 {
    #if JucePlugin_ProducesMidiOutput
@@ -120,10 +690,53 @@ void CMProjectAudioProcessor::changeProgramName (int index, const juce::String&
 {
 }
 
+// IEEE 754 half precision, as packed by Python's struct 'e' format
+static float halfToFloat(juce::uint16 half) noexcept
+{
+    const auto sign = (juce::uint32)(half & 0x8000u) << 16;
+    const auto exponent = (juce::uint32)(half >> 10) & 0x1fu;
+    auto mantissa = (juce::uint32)half & 0x3ffu;
+    juce::uint32 bits = sign;
+
+    if (exponent == 0x1fu)
+    {
+        bits |= 0x7f800000u | (mantissa << 13);
+    }
+    else if (exponent != 0)
+    {
+        bits |= ((exponent + 112u) << 23) | (mantissa << 13);
+    }
+    else if (mantissa != 0)
+    {
+        // Subnormal: shift the leading one up into the implicit bit
+        juce::uint32 shift = 0;
+
+        while ((mantissa & 0x400u) == 0)
+        {
+            mantissa <<= 1;
+            ++shift;
+        }
+
+        bits |= ((113u - shift) << 23) | ((mantissa & 0x3ffu) << 13);
+    }
+
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
 // Handle OSC messages arriving from Python tracker
 void CMProjectAudioProcessor::oscMessageReceived(const juce::OSCMessage& message)
 {
     const auto address = message.getAddressPattern().toString();
+    const auto receivedMicros = GestureClock::nowMicros();
+
+    // The tracker appends the capture time of the camera frame as a trailing int32
+    auto dueTimeOf = [&](const juce::OSCArgument& captureArg)
+    {
+        const auto latencyMicros = (juce::uint32)juce::roundToInt(gestureLatencyMs.load() * 1000.0f);
+        return gestureClock.toLocal((juce::uint32)captureArg.getInt32(), receivedMicros) + latencyMicros;
+    };
 
     auto readFloatArg = [](const juce::OSCArgument& arg) -> float
     {
@@ -140,13 +753,29 @@ void CMProjectAudioProcessor::oscMessageReceived(const juce::OSCMessage& message
         message[0].isFloat32() && message[1].isFloat32() && message[2].isFloat32() &&
         message[3].isFloat32() && message[4].isFloat32() && message[5].isFloat32())
     {
-        grainDur = message[0].getFloat32();
-        grainPos = message[1].getFloat32();
-        cutoff = message[2].getFloat32();
-        density = message[3].getFloat32();
-        pitch = message[4].getFloat32();
-        reverse = message[5].getFloat32();
+        HandGrainEvent event;
+
+        for (int i = 0; i < 6; ++i)
+            event.values[(size_t)i] = message[i].getFloat32();
 
+        const auto& lastArg = message[message.size() - 1];
+
+        if (message.size() > 6 && lastArg.isInt32())
+        {
+            event.dueMicros = dueTimeOf(lastArg);
+
+            if (! handGrainEvents.push(event))
+                DBG("Hand grain queue full, dropping update");
+        }
+        else
+        {
+            grainDur = event.values[0];
+            grainPos = event.values[1];
+            cutoff = event.values[2];
+            density = event.values[3];
+            pitch = event.values[4];
+            reverse = event.values[5];
+        }
     }
     else if (address == "/handState" && message.size() == 44 &&
              message[0].isInt32() && message[1].isInt32())
@@ -154,7 +783,13 @@ void CMProjectAudioProcessor::oscMessageReceived(const juce::OSCMessage& message
         const auto handIndex = message[0].getInt32();
         const auto visible = message[1].getInt32() != 0;
 
-        if (juce::isPositiveAndBelow(handIndex, (int) trackedHands.size()))
+        // While the tracker is on shared memory its reader owns the hand state
+        if (sharedHandFramesAttached.load())
+            return;
+
+        const juce::SpinLock::ScopedTryLockType writer (handStateWriter);
+
+        if (writer.isLocked() && juce::isPositiveAndBelow(handIndex, (int) receivedHands.size()))
         {
             TrackedHandState nextState;
             nextState.visible = visible;
@@ -171,16 +806,87 @@ void CMProjectAudioProcessor::oscMessageReceived(const juce::OSCMessage& message
                 }
             }
 
-            const juce::ScopedLock lock(trackedHandsLock);
-            trackedHands[(size_t) handIndex] = nextState;
+            // No capture stamp, so the gestures apply as soon as they arrive and only the
+            // output block is left to predict over
+            receivedHands[(size_t) handIndex] = nextState;
+            filterReceivedHand((size_t) handIndex, receivedMicros, blockLatencyMs.load());
+            publishReceivedHands(receivedMicros, true);
         }
     }
+    else if (address == "/handFrame" && message.size() == 1 && message[0].isBlob())
+    {
+        // Stragglers sent over UDP before the tracker attached; the shared-memory reader owns
+        // the hand state now.
+        if (sharedHandFramesAttached.load())
+            return;
+
+        const auto& blob = message[0].getBlob();
+        handleHandFrame(static_cast<const juce::uint8*>(blob.getData()), blob.getSize(), receivedMicros, true);
+    }
     
-    else if (address == "/triggerDrum" && message.size() == 1 && message[0].isInt32())
+    else if (address == "/triggerDrum" && (message.size() == 1 || message.size() == 2) && message[0].isInt32())
     {
         int fingerIndex = message[0].getInt32();
         DBG(" Triggering drum from finger " << fingerIndex);
-        triggerSamplePlayback(fingerIndex);
+
+        if (message.size() == 2 && message[1].isInt32())
+            scheduleDrumTrigger(fingerIndex, dueTimeOf(message[1]));
+        else
+            triggerSamplePlayback(fingerIndex);
+    }
+    else if (address == "/sequencerStep" && message.size() == 3 &&
+             message[0].isInt32() && message[1].isInt32() && message[2].isInt32())
+    {
+        setSequencerStep(message[0].getInt32(), message[1].getInt32(), message[2].getInt32() != 0);
+    }
+    else if (address == "/sequencerPattern" && message.size() == 2 && message[0].isInt32() && message[1].isInt32())
+    {
+        setSequencerPattern(message[0].getInt32(), (juce::uint16)message[1].getInt32());
+    }
+    else if (address == "/sequencerRunning" && message.size() == 1 && message[0].isInt32())
+    {
+        setSequencerRunning(message[0].getInt32() != 0);
+    }
+    else if (address == "/drumChokeGroup" && message.size() == 2 && message[0].isInt32() && message[1].isInt32())
+    {
+        setDrumChokeGroup(message[0].getInt32(), message[1].getInt32());
+    }
+    else if (address == "/drumVolume" && message.size() == 2 && message[0].isInt32()
+             && (message[1].isFloat32() || message[1].isInt32()))
+    {
+        setTrackVolume(message[0].getInt32(), readFloatArg(message[1]));
+    }
+    else if (address == "/windowShape" && message.size() == 1 && message[0].isInt32())
+    {
+        setWindowShape(message[0].getInt32());
+    }
+    else if (address == "/windowTaper" && message.size() == 1 && (message[0].isFloat32() || message[0].isInt32()))
+    {
+        setWindowTaper(readFloatArg(message[0]));
+    }
+    else if (address == "/grainFilterMode" && message.size() == 1 && message[0].isInt32())
+    {
+        setGrainFilterMode(message[0].getInt32());
+    }
+    else if (address == "/voiceStealMode" && message.size() == 1 && message[0].isInt32())
+    {
+        setVoiceStealMode(message[0].getInt32());
+    }
+    else if (address == "/grainBudget" && message.size() == 1 && message[0].isInt32())
+    {
+        setGrainBudget(message[0].getInt32());
+    }
+    else if (address == "/interpolationMode" && message.size() == 2 && message[0].isInt32() && message[1].isInt32())
+    {
+        setInterpolationMode(message[0].getInt32(), message[1].getInt32() != 0);
+    }
+    else if (address == "/gestureLatency" && message.size() == 1 && (message[0].isFloat32() || message[0].isInt32()))
+    {
+        setGestureLatencyMs(readFloatArg(message[0]));
+    }
+    else if (address == "/landmarkPrediction" && message.size() == 1 && (message[0].isFloat32() || message[0].isInt32()))
+    {
+        setLandmarkPredictionMs(readFloatArg(message[0]));
     }
     else
     {
@@ -204,43 +910,375 @@ void CMProjectAudioProcessor::updateParameters() {
 //==============================================================================
 void CMProjectAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
-    juce::ignoreUnused(samplesPerBlock);
     currentSampleRate = sampleRate;
-    samplesUntilNextGrain = 0.0;
-    heldSynthNotes = 0;
-    currentPitchRatio = 1.0f;
     pitchWheelSemitones = 0.0f;
-    activeGrains.clear();
-
-    // Python receiver
-    if (!oscReceiver.connect(9001)) // match Python port
-        DBG("❌ Could not bind OSC receiver on 9001");
-    else {
-        oscReceiver.addListener(this, "/handGrain");
-        oscReceiver.addListener(this, "/handState");
-        oscReceiver.addListener(this, "/triggerDrum");
-        DBG("✅ JUCE OSC Receiver listening on port 9001");
+    blockLatencyMs.store((float)(juce::jmax(1, samplesPerBlock) * 1000.0 / sampleRate));
+
+    jassert(getTotalNumOutputChannels() <= maxRenderChannels);
+
+    // Room for every voice triggering at maxGrainRateHz with the longest grains, plus a block
+    // of triggers landing before any grain retires, doubled for the forward/reverse pairs fired
+    // while reverse crossfades. About 850 grains at 48 kHz and 512 samples.
+    const double blockSeconds = juce::jmax(1, samplesPerBlock) / sampleRate;
+    const int grainsPerVoice = 2 * ((int)std::ceil(maxGrainRateHz * (maxGrainSeconds + blockSeconds)) + 1);
+    const int poolCapacity = grainsPerVoice * maxSynthVoices;
+
+    grainPool.allocate(poolCapacity);
+    grainBatched.assign((size_t)poolCapacity, 0);
+    grainPoolCapacity.store(poolCapacity);
+    voiceMix.setSize(maxSynthVoices * maxRenderChannels, juce::jmax(1, samplesPerBlock));
+    synthVoices.fill(SynthVoice());
+    nextVoiceOrder = 0;
+    stealFadeSamples = juce::jmax(1, juce::roundToInt(sampleRate * 0.005));
+    drumFadeSamples = juce::jmax(1, juce::roundToInt(sampleRate * 0.002));
+
+    for (size_t track = 0; track < 4; ++track)
+    {
+        smoothedTrackGains[track].reset(sampleRate, 0.02);
+        smoothedTrackGains[track].setCurrentAndTargetValue(trackVolumes[track].load());
     }
 
-}
+    for (auto& voice : drumVoices)
+        voice = DrumVoice();
 
-std::array<CMProjectAudioProcessor::TrackedHandState, 2> CMProjectAudioProcessor::getTrackedHands() const
-{
-    const juce::ScopedLock lock(trackedHandsLock);
-    return trackedHands;
-}
+    numPendingDrumTriggers = 0;
+    numPendingHandGrains = 0;
+    gridTriggers.assign((size_t)juce::jmax(1, samplesPerBlock), 0);
+    sequencerTriggers.assign((size_t)juce::jmax(1, samplesPerBlock), 0);
+    transportClock = {};
+    freeRunningPpq = 0.0;
+    updateGrainRamps(0);
 
-void CMProjectAudioProcessor::clearTrackedHands()
-{
-    const juce::ScopedLock lock(trackedHandsLock);
+    // Loaded audio is converted in the background; until that finishes, the copies at the old
+    // rate keep playing. A file still decoding picks up the new rate when it hands over.
+    {
+        const juce::ScopedLock lock(loadedSampleLock);
 
-    for (auto& hand : trackedHands)
-        hand = {};
-}
+        if (sampleRate != conversionRate)
+        {
+            conversionRate = sampleRate;
 
+            for (int slot = 0; slot < numConversionSlots; ++slot)
+                if (! decodingSlots[(size_t)slot])
+                    startSampleConversion(slot);
+        }
+    }
 
-void CMProjectAudioProcessor::releaseResources()
-{
+    grainKernel = detectGrainKernel();
+
+    // Python receiver. Bound once; the listeners were registered in the constructor, before the
+    // receiver thread existed, since that thread walks the listener list without a lock.
+    if (! oscReceiverConnected)
+    {
+        if (!oscReceiver.connect(9001)) // match Python port
+            DBG("❌ Could not bind OSC receiver on 9001");
+        else {
+            oscReceiverConnected = true;
+            DBG("✅ JUCE OSC Receiver listening on port 9001");
+        }
+    }
+
+}
+
+// Binary frame with both hands, read in place from the OSC blob. Version 1, little-endian:
+//   uint8 version, uint8 visible hands (bit 0 left, bit 1 right), uint16 landmarks per hand,
+//   uint32 sequence, uint32 capture time in microseconds (the tracker's clock),
+//   then for each hand: float32 handedness score, and per landmark float16 x, y, confidence.
+void CMProjectAudioProcessor::handleHandFrame(const juce::uint8* data, size_t size, juce::uint32 receivedMicros,
+                                              bool fromOscThread)
+{
+    constexpr size_t headerSize = 12;
+    constexpr int numLandmarks = 21;
+    constexpr size_t handSize = 4 + (size_t)numLandmarks * 6;
+    static_assert(headerSize + 2 * handSize == (size_t)handFrameBytes, "hand frame layout mismatch");
+
+    if (size < (size_t)handFrameBytes || data[0] != handFrameVersion
+        || juce::ByteOrder::littleEndianShort(data + 2) != numLandmarks)
+    {
+        DBG(" Malformed or unsupported hand frame, size=" << (int)size);
+        return;
+    }
+
+    // Only one thread may write the hand state at a time. The OSC thread stands down once the
+    // shared memory is attached, but a frame it was already handling can overlap the reader's
+    // first; that frame is dropped rather than interleaved.
+    const juce::SpinLock::ScopedTryLockType writer (handStateWriter);
+
+    if (! writer.isLocked())
+        return;
+
+    // A new tracker process: forget the old one's sequence, latency and filter state.
+    if (trackerRestarted.exchange(false))
+    {
+        hasTrackerFrame = false;
+        trackerLatencyMs = -1.0f;
+        handFilters.fill(HandFilter());
+    }
+
+    // UDP can reorder datagrams: drop anything not newer than the last frame, unless the
+    // sequence went back far enough to mean the tracker was restarted.
+    const auto sequence = juce::ByteOrder::littleEndianInt(data + 4);
+    const auto age = (juce::int32)(lastTrackerFrameSequence - sequence);
+
+    if (hasTrackerFrame && age >= 0 && age < 1000)
+        return;
+
+    hasTrackerFrame = true;
+    lastTrackerFrameSequence = sequence;
+
+    // Frames arrive steadily, so they keep the OSC clock estimate fresh between triggers. The
+    // gestures they drive sound the same fixed latency after capture as the triggers do; frames
+    // from shared memory use the reader thread's own estimate.
+    const auto captureMicros = juce::ByteOrder::littleEndianInt(data + 8);
+    auto& clock = fromOscThread ? gestureClock : sharedGestureClock;
+    const auto latencyMicros = (juce::uint32)juce::roundToInt(gestureLatencyMs.load() * 1000.0f);
+    const auto dueMicros = clock.toLocal(captureMicros, receivedMicros) + latencyMicros;
+
+    // The tracker stamps frames with the system's monotonic clock, which on macOS and Linux is
+    // the one nowMicros reads too, so the difference is the real capture-to-receive latency.
+    // Anything outside a second means the clocks differ and nothing can be measured.
+    const auto transitMicros = (juce::int32)(receivedMicros - captureMicros);
+
+    if (transitMicros >= 0 && transitMicros < 1000000)
+    {
+        const float transitMs = (float)transitMicros * 0.001f;
+        trackerLatencyMs = trackerLatencyMs < 0.0f ? transitMs : trackerLatencyMs + 0.05f * (transitMs - trackerLatencyMs);
+    }
+    else
+    {
+        trackerLatencyMs = -1.0f;
+    }
+
+    measuredTrackerLatencyMs.store(trackerLatencyMs);
+
+    // The gestures sound at dueMicros and reach the speakers a block later. With both clocks
+    // the same, capture to due is measured directly; otherwise the clock estimate already
+    // hides the fastest transit, so only the fixed latency on top of it is known.
+    const float captureToDueMs = trackerLatencyMs >= 0.0f ? (float)(juce::int32)(dueMicros - captureMicros) * 0.001f
+                                                          : gestureLatencyMs.load();
+    const float autoHorizonMs = juce::jlimit(0.0f, maxPredictionMs, captureToDueMs + blockLatencyMs.load());
+
+    for (size_t hand = 0; hand < receivedHands.size(); ++hand)
+    {
+        const auto* record = data + headerSize + hand * handSize;
+        TrackedHandState state;
+        state.visible = ((data[1] >> hand) & 1) != 0;
+
+        if (state.visible)
+        {
+            state.handedness = juce::ByteOrder::littleEndianFloat(record);
+
+            for (size_t i = 0; i < (size_t)numLandmarks; ++i)
+            {
+                const auto* point = record + 4 + i * 6;
+                state.landmarks[i] = { halfToFloat(juce::ByteOrder::littleEndianShort(point)),
+                                       halfToFloat(juce::ByteOrder::littleEndianShort(point + 2)) };
+                state.confidence[i] = halfToFloat(juce::ByteOrder::littleEndianShort(point + 4));
+            }
+        }
+
+        receivedHands[hand] = state;
+        filterReceivedHand(hand, captureMicros, autoHorizonMs);
+    }
+
+    publishReceivedHands(dueMicros, fromOscThread);
+}
+
+float CMProjectAudioProcessor::OneEuroFilter::process(float x, float dt) noexcept
+{
+    auto smoothingFactor = [dt](float cutoff)
+    {
+        const float timeConstant = 1.0f / (juce::MathConstants<float>::twoPi * cutoff);
+        return 1.0f / (1.0f + timeConstant / dt);
+    };
+
+    if (! isPrimed)
+    {
+        isPrimed = true;
+        value = x;
+        derivative = 0.0f;
+        return value;
+    }
+
+    derivative += smoothingFactor(derivativeCutoff) * ((x - value) / dt - derivative);
+    value += smoothingFactor(minCutoff + beta * std::abs(derivative)) * (x - value);
+    return value;
+}
+
+// Filters one hand of receivedHands into filteredHands. frameMicros is the capture time when
+// the tracker sent one, else the receive time; only differences between frames are used.
+void CMProjectAudioProcessor::filterReceivedHand(size_t hand, juce::uint32 frameMicros, float autoHorizonMs)
+{
+    const auto& input = receivedHands[hand];
+    auto& output = filteredHands[hand];
+    auto& filter = handFilters[hand];
+    output = input;
+
+    // A hand that reappears starts from where it is seen, not from where it was lost
+    if (! input.visible)
+    {
+        for (auto& coordinate : filter.coordinates)
+            coordinate.isPrimed = false;
+
+        return;
+    }
+
+    const auto elapsedMicros = (juce::int32)(frameMicros - filter.lastFrameMicros);
+    const float dt = elapsedMicros > 0 && elapsedMicros < 500000 ? (float)elapsedMicros * 1.0e-6f : 1.0f / 30.0f;
+    filter.lastFrameMicros = frameMicros;
+
+    const float requestedMs = landmarkPredictionMs.load();
+    const float predictionMs = requestedMs >= 0.0f ? requestedMs : autoHorizonMs;
+    const float horizon = predictionMs * 0.001f;
+
+    for (size_t i = 0; i < output.landmarks.size(); ++i)
+    {
+        auto& x = filter.coordinates[i * 2];
+        auto& y = filter.coordinates[i * 2 + 1];
+        x.process(input.landmarks[i].x, dt);
+        y.process(input.landmarks[i].y, dt);
+        output.landmarks[i] = { x.value + x.derivative * horizon, y.value + y.derivative * horizon };
+    }
+}
+
+void CMProjectAudioProcessor::publishReceivedHands(juce::uint32 dueMicros, bool fromOscThread)
+{
+    auto& frame = handFrames.getWriteFrame();
+    frame.hands = filteredHands;
+    frame.sequence = lastHandSequence.load() + 1;
+    handFrames.publish();
+    lastHandSequence.store(frame.sequence);
+
+    runGestureEngine(dueMicros, fromOscThread);
+}
+
+int CMProjectAudioProcessor::getFingerParameterId(const juce::String& name) noexcept
+{
+    static const char* const names[] = { "GrainDur", "GrainPos", "GrainCutOff", "GrainDensity", "GrainPitch", "GrainReverse" };
+
+    for (int i = 0; i < numFingerParameters; ++i)
+        if (name == names[i])
+            return i;
+
+    return -1;
+}
+
+void CMProjectAudioProcessor::GestureCurve::build()
+{
+    for (int i = 0; i <= tableSize; ++i)
+        table[(size_t)i] = std::pow((float)i / (float)tableSize, power);
+}
+
+// Normalises x to [inMin, inMax], clamps, and bends it by the power curve
+float CMProjectAudioProcessor::GestureCurve::map(float x, float inMin, float inMax, float outMin, float outMax) const noexcept
+{
+    const float position = juce::jlimit(0.0f, 1.0f, (x - inMin) / (inMax - inMin)) * (float)tableSize;
+    const int index = juce::jmin((int)position, tableSize - 1);
+    const float curved = table[(size_t)index] + (position - (float)index) * (table[(size_t)index + 1] - table[(size_t)index]);
+    return outMin + curved * (outMax - outMin);
+}
+
+// Same mappings and thresholds the tracker script used. Hand 0 is the left hand. The result
+// goes through the calling thread's grain queue, so it lands at dueMicros like a timed /handGrain.
+void CMProjectAudioProcessor::runGestureEngine(juce::uint32 dueMicros, bool fromOscThread)
+{
+    if (! synthPageActive.load())
+        return;
+
+    const auto& left = filteredHands[0];
+    const auto& right = filteredHands[1];
+
+    // A fist: every fingertip below its middle joint
+    auto isFist = [](const TrackedHandState& hand)
+    {
+        for (size_t tip : { 8, 12, 16, 20 })
+            if (hand.landmarks[tip].y <= hand.landmarks[tip - 2].y)
+                return false;
+
+        return true;
+    };
+
+    if (! right.visible || (left.visible && isFist(left)))
+        return;
+
+    constexpr float inMin = 0.02f;
+    constexpr float inMax = 0.70f;
+    const auto thumb = right.landmarks[4];
+    const float sampleSeconds = synthSampleSeconds.load();
+    HandGrainEvent event;
+    event.mask = 0;
+    event.dueMicros = dueMicros;
+
+    for (size_t finger = 0; finger < fingerParameterIds.size(); ++finger)
+    {
+        const float distance = thumb.getDistanceFrom(right.landmarks[8 + finger * 4]);
+        const int parameter = fingerParameterIds[finger].load();
+        float value = 0.0f;
+
+        switch (parameter)
+        {
+            case fingerGrainDur:     value = gestureCurve.map(distance, inMin, inMax, 0.005f, juce::jmin(0.5f, sampleSeconds * 0.1f)); break;
+            case fingerGrainPos:     value = gestureCurve.map(distance, inMin, inMax, 0.0f, sampleSeconds); break;
+            case fingerGrainCutOff:  value = gestureCurve.map(distance, inMin, inMax, 50.0f, 15000.0f); break;
+            case fingerGrainDensity: value = gestureCurve.map(distance, inMin, inMax, 0.005f, 5.0f); break;
+            case fingerGrainPitch:   value = gestureCurve.map(distance, inMin, inMax, -12.0f, 12.0f); break;
+            case fingerGrainReverse: value = distance < 0.05f ? 1.0f : 0.0f; break;
+            default: continue;
+        }
+
+        event.values[(size_t)parameter] = value;
+        event.mask |= (juce::uint8)(1 << parameter);
+    }
+
+    if (event.mask != 0 && ! (fromOscThread ? handGrainEvents : sharedHandGrainEvents).push(event))
+        DBG("Hand grain queue full, dropping gesture");
+}
+
+void CMProjectAudioProcessor::resetGestureParameters()
+{
+    grainDur.store(0.02f);
+    grainPos.store(0.01f);
+    cutoff.store(3000.0f);
+    density.store(0.8f);
+    pitch.store(1.0f);
+    reverse.store(0.0f);
+}
+
+const CMProjectAudioProcessor::HandFrame& CMProjectAudioProcessor::getLatestHandFrame() const
+{
+    const auto& frame = handFrames.read();
+
+    // Frames published before the last clear (including any still in flight from a tracker
+    // that was just stopped) read as no hands.
+    if ((juce::int32)(frame.sequence - handsClearedThrough) <= 0)
+        return clearedHandFrame;
+
+    return frame;
+}
+
+// Clearing happens on the reader side, so the OSC receiver stays the buffer's only writer.
+void CMProjectAudioProcessor::clearTrackedHands()
+{
+    handsClearedThrough = lastHandSequence.load();
+    trackerRestarted.store(true);
+}
+
+void CMProjectAudioProcessor::HandFrameTripleBuffer::publish() noexcept
+{
+    writeIndex = middleIndex.exchange(writeIndex | newFrameBit, std::memory_order_acq_rel) & ~newFrameBit;
+}
+
+const CMProjectAudioProcessor::HandFrame& CMProjectAudioProcessor::HandFrameTripleBuffer::read() noexcept
+{
+    if ((middleIndex.load(std::memory_order_acquire) & newFrameBit) != 0)
+        readIndex = middleIndex.exchange(readIndex, std::memory_order_acq_rel) & ~newFrameBit;
+
+    return frames[(size_t)readIndex];
+}
+
+
+void CMProjectAudioProcessor::releaseResources()
+{
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
 }
@@ -260,6 +1298,10 @@ bool CMProjectAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts
      && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
         return false;
 
+    // The renderers hold per-channel state for at most maxRenderChannels
+    if (layouts.getMainOutputChannelSet().size() > maxRenderChannels)
+        return false;
+
     // This checks if the input layout matches the output layout
    #if ! JucePlugin_IsSynth
     if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
@@ -280,130 +1322,68 @@ void CMProjectAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juc
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear(i, 0, buffer.getNumSamples());
 
-    // MIDI handling
-    for (const auto metadata : midiMessages)
-    {
-        auto msg = metadata.getMessage();
-
-        if (msg.isNoteOn())
-        {
-            auto note = msg.getNoteNumber(); // 0–127
-            auto vel = msg.getVelocity() / 127.0f; // normalized 0.0–1.0
-            startManualSynthNote(note, vel);
-        }
-        else if (msg.isNoteOff())
-        {
-            auto note = msg.getNoteNumber();
-            stopManualSynthNote(note);
-        }
-        else if (msg.isPitchWheel())
-        {
-            const int raw = msg.getPitchWheelValue();
-            const float norm = (raw - 8192) / 8192.0f; // -1..+1
-            pitchWheelSemitones = norm * 2.0f;         // SC behavior: +-2 semitones
-        }
-
-        if (isRecordingMidi)
-            recordedSequence.addEvent(msg);
-    }
+    blockStartMicros = GestureClock::nowMicros();
 
     // ===============================
     // 🎵 Drum sample mixing logic
     // ===============================
     const int numSamples = buffer.getNumSamples();
-    const int numChannels = buffer.getNumChannels();
-
-    std::scoped_lock lock(sampleMutex);
 
+    // A newly loaded one-shot is used from the next hit on; hits already sounding finish on
+    // the old one, and the release pool frees it once they are done.
     for (int track = 0; track < 4; ++track)
     {
-        if (triggerPlayback[track] && sampleLoaded[track])
-        {
-            
-            const auto& sample = drumSamples[track];
-            const int sampleLength = sample.getNumSamples();
+        auto* latest = publishedDrumSamples[(size_t)track].load(std::memory_order_acquire);
 
-            for (int i = 0; i < numSamples; ++i)
-            {
-                if (playbackPositions[track] >= sampleLength)
-                    break;
-
-                for (int ch = 0; ch < numChannels; ++ch)
-                {
-                    float* out = buffer.getWritePointer(ch);
-                    const float* in = sample.getReadPointer(juce::jmin(ch, sample.getNumChannels() - 1));
-                    out[i] += in[playbackPositions[track]] * trackVolumes[track];
-                }
-
-                playbackPositions[track]++;
-            }
-            if (playbackPositions[track] >= sampleLength)
-                triggerPlayback[track] = false;
-        }
+        if (latest != activeDrumSamples[(size_t)track].get())
+            activeDrumSamples[(size_t)track] = latest;
     }
 
-    // Built-in granular synth
-    std::scoped_lock synthLock(synthSampleMutex);
-    if (synthSampleLoaded && synthSample.getNumSamples() > 1
-        && (heldSynthNotes > 0 || !activeGrains.empty()))
-    {
-        const int sampleLength = synthSample.getNumSamples();
-        const int sourceChannels = synthSample.getNumChannels();
-
-        const float densityValue = juce::jmax(0.01f, density.load());
-        const double bpm = 120.0;
-        // Match SC: trigRate = ((bpm / 60) * 4 * density).max(0.1)
-        const double grainsPerSecond = juce::jmax(0.1, ((bpm / 60.0) * 4.0 * (double)densityValue));
-        const double spawnIntervalSamples = currentSampleRate / grainsPerSecond;
-        const float cutoffValue = juce::jlimit(20.0f, 20000.0f, cutoff.load());
-        const double dt = 1.0 / juce::jmax(1.0, currentSampleRate);
-        const double rc = 1.0 / (2.0 * juce::MathConstants<double>::pi * cutoffValue);
-        const float lowpassAlpha = (float)juce::jlimit(0.0, 1.0, dt / (rc + dt));
+    updateTransportClock(numSamples);
+    renderDrums(buffer, numSamples);
 
-        for (int i = 0; i < numSamples; ++i)
-        {
-            samplesUntilNextGrain -= 1.0;
-            while (heldSynthNotes > 0 && samplesUntilNextGrain <= 0.0 && (int)activeGrains.size() < 96)
-            {
-                spawnGrain();
-                samplesUntilNextGrain += spawnIntervalSamples;
-            }
+    // Built-in granular synth
+    // Pick up a newly loaded sample. Grains still point into the old one, so they are dropped.
+    // The release pool holds its own reference, so letting go of the old sample here never
+    // frees it on the audio thread.
+    if (auto* latest = publishedSynthSample.load(std::memory_order_acquire); latest != activeSynthSample.get())
+    {
+        activeSynthSample = latest;
+        resetSynthVoices();
+    }
 
-            for (int g = (int)activeGrains.size() - 1; g >= 0; --g)
-            {
-                auto& grain = activeGrains[(size_t)g];
+    applyDueHandGrains(numSamples);
+    updateGrainRamps(numSamples);
 
-                if (grain.remainingSamples <= 0)
-                {
-                    activeGrains.erase(activeGrains.begin() + g);
-                    continue;
-                }
+    // Notes played from the GUI land on the first sample of the block
+    SynthNoteEvent noteEvent;
+    while (guiNoteEvents.pop(noteEvent))
+    {
+        if (noteEvent.velocity > 0.0f)
+            synthNoteOn(noteEvent.noteNumber, noteEvent.velocity);
+        else
+            synthNoteOff(noteEvent.noteNumber);
+    }
 
-                const int idx0 = juce::jlimit(0, sampleLength - 1, (int)grain.samplePos);
-                const int idx1 = juce::jlimit(0, sampleLength - 1, idx0 + 1);
-                const float frac = (float)(grain.samplePos - (double)idx0);
-                const float progress = 1.0f - ((float)grain.remainingSamples / (float)grain.totalSamples);
-                const float env = 0.5f - 0.5f * std::cos(juce::MathConstants<float>::twoPi * progress);
+    // MIDI handling: the synth is rendered up to each event's sample position before the
+    // event is applied, so notes and pitch bends take effect exactly where the host put them.
+    int renderedUpTo = 0;
 
-                for (int ch = 0; ch < numChannels; ++ch)
-                {
-                    const float* src = synthSample.getReadPointer(juce::jmin(ch, sourceChannels - 1));
-                    const float s0 = src[idx0];
-                    const float s1 = src[idx1];
-                    const float raw = (s0 + (s1 - s0) * frac) * grain.gain * env;
-                    grain.lowpassState += lowpassAlpha * (raw - grain.lowpassState);
-                    buffer.addSample(ch, i, grain.lowpassState);
-                }
+    for (const auto metadata : midiMessages)
+    {
+        const int eventSample = juce::jlimit(renderedUpTo, numSamples, metadata.samplePosition);
+        renderSynthRange(buffer, renderedUpTo, eventSample - renderedUpTo);
+        renderedUpTo = eventSample;
 
-                grain.samplePos += grain.sampleStep;
-                grain.remainingSamples--;
+        auto msg = metadata.getMessage();
+        handleSynthMidi(msg);
 
-                if (grain.samplePos < 0.0 || grain.samplePos >= (double)(sampleLength - 1))
-                    grain.remainingSamples = 0;
-            }
-        }
+        if (isRecordingMidi)
+            recordedSequence.addEvent(msg);
     }
 
+    renderSynthRange(buffer, renderedUpTo, numSamples - renderedUpTo);
+
     {
         const juce::ScopedLock lock(audioRecordingLock);
 
@@ -425,17 +1405,58 @@ juce::AudioProcessorEditor* CMProjectAudioProcessor::createEditor()
 }
 
 //==============================================================================
+// The drum sequencer and the engine settings are saved with the session, so a pattern or a
+// choke setup survives reloading the project.
 void CMProjectAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
+    juce::XmlElement state ("CMProjectState");
+    state.setAttribute ("sequencerRunning", sequencerRunning.load() ? 1 : 0);
+    state.setAttribute ("windowShape", getWindowShape());
+    state.setAttribute ("windowTaper", (double) getWindowTaper());
+    state.setAttribute ("grainFilterMode", getGrainFilterMode());
+    state.setAttribute ("voiceStealMode", getVoiceStealMode());
+    state.setAttribute ("grainBudget", grainBudget.load()); // as set, so "whole pool" stays that way
+    state.setAttribute ("liveInterpolation", getInterpolationMode (false));
+    state.setAttribute ("offlineInterpolation", getInterpolationMode (true));
+    state.setAttribute ("gestureLatencyMs", (double) getGestureLatencyMs());
+    state.setAttribute ("landmarkPredictionMs", (double) getLandmarkPredictionMs());
+
+    for (int track = 0; track < 4; ++track)
+    {
+        state.setAttribute ("sequencerPattern" + juce::String (track), (int) sequencerPatterns[(size_t) track].load());
+        state.setAttribute ("drumChokeGroup" + juce::String (track), getDrumChokeGroup (track));
+        state.setAttribute ("trackVolume" + juce::String (track), (double) getTrackVolume (track));
+    }
+
+    copyXmlToBinary (state, destData);
 }
 
 void CMProjectAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
+    const auto state = getXmlFromBinary (data, sizeInBytes);
+
+    if (state == nullptr || ! state->hasTagName ("CMProjectState"))
+        return;
+
+    for (int track = 0; track < 4; ++track)
+    {
+        setSequencerPattern (track, (juce::uint16) state->getIntAttribute ("sequencerPattern" + juce::String (track)));
+        setDrumChokeGroup (track, state->getIntAttribute ("drumChokeGroup" + juce::String (track)));
+        setTrackVolume (track, (float) state->getDoubleAttribute ("trackVolume" + juce::String (track), getTrackVolume (track)));
+    }
+
+    setSequencerRunning (state->getIntAttribute ("sequencerRunning") != 0);
+
+    // Sessions saved before a setting existed keep the current value
+    setWindowShape (state->getIntAttribute ("windowShape", getWindowShape()));
+    setWindowTaper ((float) state->getDoubleAttribute ("windowTaper", getWindowTaper()));
+    setGrainFilterMode (state->getIntAttribute ("grainFilterMode", getGrainFilterMode()));
+    setVoiceStealMode (state->getIntAttribute ("voiceStealMode", getVoiceStealMode()));
+    setGrainBudget (state->getIntAttribute ("grainBudget", grainBudget.load()));
+    setInterpolationMode (state->getIntAttribute ("liveInterpolation", getInterpolationMode (false)), false);
+    setInterpolationMode (state->getIntAttribute ("offlineInterpolation", getInterpolationMode (true)), true);
+    setGestureLatencyMs ((float) state->getDoubleAttribute ("gestureLatencyMs", getGestureLatencyMs()));
+    setLandmarkPredictionMs ((float) state->getDoubleAttribute ("landmarkPredictionMs", getLandmarkPredictionMs()));
 }
 
 //==============================================================================
@@ -451,102 +1472,419 @@ void CMProjectAudioProcessor::loadSampleForTrack(int trackIndex, const juce::Fil
     if (trackIndex < 0 || trackIndex >= 4)
         return;
 
-    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
-    if (reader != nullptr)
-    {
-        //DBG("Loading sample for track " << trackIndex << ": " << file.getFullPathName());
-        //DBG("Channels: " << reader->numChannels << ", Samples: " << reader->lengthInSamples);
-        juce::AudioBuffer<float> tempBuffer((int)reader->numChannels, (int)reader->lengthInSamples);
-        reader->read(&tempBuffer, 0, (int)reader->lengthInSamples, 0, true, true);
-
-        std::scoped_lock lock(sampleMutex);
-        drumSamples[trackIndex] = std::move(tempBuffer);
-        sampleLoaded[trackIndex] = true;
-        playbackPositions[trackIndex] = 0;
-    }
+    //DBG("Loading sample for track " << trackIndex << ": " << file.getFullPathName());
+    startSampleLoad(trackIndex, file);
 }
 
-void CMProjectAudioProcessor::triggerSamplePlayback(int trackIndex)
+// Audio thread. Fades out the track's oldest hit once it has maxVoicesPerDrumTrack sounding,
+// and every hit in the same choke group on other tracks.
+void CMProjectAudioProcessor::startDrumVoice(int track) noexcept
 {
-    if (trackIndex >= 0 && trackIndex < 4 && sampleLoaded[trackIndex])
-    {
-        std::scoped_lock lock(sampleMutex);
-
-        //Force reset position
-        playbackPositions[trackIndex] = 0;
-        triggerPlayback[trackIndex] = false; // cancel any residual state
-        triggerPlayback[trackIndex] = true;
-    }
-}
+    if (! juce::isPositiveAndBelow(track, 4) || activeDrumSamples[(size_t)track] == nullptr)
+        return;
 
-bool CMProjectAudioProcessor::saveMidiRecording(const juce::File& file)
-{
-    juce::MidiFile midiFile;
-    midiFile.setTicksPerQuarterNote(960);
-    midiFile.addTrack(recordedSequence);
+    const int chokeGroup = drumChokeGroups[(size_t)track].load();
+    int numOnTrack = 0;
+    int oldestOnTrack = -1;
 
-    if (auto stream = file.createOutputStream())
+    for (int v = 0; v < maxDrumVoices; ++v)
     {
-        midiFile.writeTo(*stream);
-        return true;
-    }
-    return false;
-}
+        auto& voice = drumVoices[(size_t)v];
 
-bool CMProjectAudioProcessor::startAudioRecording()
-{
-    if (currentSampleRate <= 0.0 || getTotalNumOutputChannels() <= 0)
-        return false;
+        if (! voice.isActive() || voice.fadeRemaining > 0)
+            continue;
 
-    stopAudioRecording();
+        if (voice.track == track)
+        {
+            ++numOnTrack;
 
-    auto tempFile = juce::File::getSpecialLocation(juce::File::tempDirectory)
-                        .getNonexistentChildFile("hand-granulator-take", ".wav");
+            if (oldestOnTrack < 0 || (juce::int32)(voice.startOrder - drumVoices[(size_t)oldestOnTrack].startOrder) < 0)
+                oldestOnTrack = v;
+        }
+        else if (chokeGroup > 0 && drumChokeGroups[(size_t)voice.track].load() == chokeGroup)
+        {
+            voice.fadeRemaining = drumFadeSamples;
+        }
+    }
 
-    auto fileStream = std::unique_ptr<juce::FileOutputStream>(tempFile.createOutputStream());
+    if (numOnTrack >= maxVoicesPerDrumTrack)
+        drumVoices[(size_t)oldestOnTrack].fadeRemaining = drumFadeSamples;
 
-    if (fileStream == nullptr)
-        return false;
+    // A free slot, or failing that the fading voice closest to silence, or the oldest voice.
+    int slot = -1;
 
-    juce::WavAudioFormat wavFormat;
-    auto* writer = wavFormat.createWriterFor(fileStream.get(),
-                                             currentSampleRate,
-                                             (unsigned int) juce::jmax(1, getTotalNumOutputChannels()),
-                                             24,
-                                             {},
-                                             0);
+    for (int v = 0; v < maxDrumVoices; ++v)
+    {
+        const auto& voice = drumVoices[(size_t)v];
 
-    if (writer == nullptr)
-        return false;
+        if (! voice.isActive())
+        {
+            slot = v;
+            break;
+        }
 
-    fileStream.release();
+        if (slot < 0)
+        {
+            slot = v;
+            continue;
+        }
 
-    auto nextThreadedWriter = std::make_unique<juce::AudioFormatWriter::ThreadedWriter>(writer,
-                                                                                         audioRecordingThread,
-                                                                                         32768);
+        const auto& best = drumVoices[(size_t)slot];
+        const bool fading = voice.fadeRemaining > 0;
+        const bool bestFading = best.fadeRemaining > 0;
 
-    {
-        const juce::ScopedLock lock(audioRecordingLock);
-        currentAudioRecordingFile = tempFile;
-        latestAudioRecordingFile = juce::File();
-        threadedAudioWriter = std::move(nextThreadedWriter);
-        activeAudioWriter.store(threadedAudioWriter.get());
-        isRecordingAudio.store(true);
+        if (fading != bestFading ? fading
+                                 : fading ? voice.fadeRemaining < best.fadeRemaining
+                                          : (juce::int32)(voice.startOrder - best.startOrder) < 0)
+            slot = v;
     }
 
-    return true;
+    auto& voice = drumVoices[(size_t)slot];
+    voice.sample = activeDrumSamples[(size_t)track];
+    voice.track = track;
+    voice.position = 0;
+    voice.startOrder = nextDrumVoiceOrder++;
+    voice.fadeRemaining = 0;
 }
 
-void CMProjectAudioProcessor::stopAudioRecording()
+void CMProjectAudioProcessor::setSequencerStep(int trackIndex, int step, bool isOn)
 {
-    const juce::ScopedLock lock(audioRecordingLock);
+    if (! juce::isPositiveAndBelow(trackIndex, 4) || ! juce::isPositiveAndBelow(step, numSequencerSteps))
+        return;
 
-    activeAudioWriter.store(nullptr);
-    threadedAudioWriter.reset();
-    isRecordingAudio.store(false);
+    const auto bit = (juce::uint16)(1u << step);
+    auto& pattern = sequencerPatterns[(size_t)trackIndex];
 
-    if (currentAudioRecordingFile.existsAsFile())
-        latestAudioRecordingFile = currentAudioRecordingFile;
+    if (isOn)
+        pattern.fetch_or(bit);
+    else
+        pattern.fetch_and((juce::uint16)~bit);
+}
+
+// Hits from the GUI and untimed OSC triggers land on the first sample of the block; timed
+// gestures and sequencer steps land on their own sample. The drums are mixed up to each hit
+// before its voice starts.
+void CMProjectAudioProcessor::renderDrums(juce::AudioBuffer<float>& buffer, int numSamples) noexcept
+{
+    numDrumHits = 0;
+
+    DrumTrigger trigger;
+    while (drumTriggers.pop(trigger))
+    {
+        if (trigger.isTimed && numPendingDrumTriggers < (int)pendingDrumTriggers.size())
+            pendingDrumTriggers[(size_t)numPendingDrumTriggers++] = trigger;
+        else
+            addDrumHit(0, trigger.track);
+    }
+
+    int numStillPending = 0;
+
+    for (int i = 0; i < numPendingDrumTriggers; ++i)
+    {
+        const auto pending = pendingDrumTriggers[(size_t)i];
+        const int offset = samplesUntilDue(pending.dueMicros);
+
+        if (offset < numSamples)
+            addDrumHit(offset, pending.track);
+        else
+            pendingDrumTriggers[(size_t)numStillPending++] = pending;
+    }
+
+    numPendingDrumTriggers = numStillPending;
+
+    if (sequencerRunning.load())
+    {
+        constexpr double stepBeats = 0.25;
+        const int numSteps = transportClock.findGridTriggers(0, numSamples, stepBeats,
+                                                             sequencerTriggers.data(), (int)sequencerTriggers.size());
+
+        for (int i = 0; i < numSteps; ++i)
+        {
+            const int offset = sequencerTriggers[(size_t)i];
+
+            // The grid point sits within half a sample of this offset, so rounding recovers it.
+            const auto stepCount = (juce::int64)std::floor(transportClock.ppqAt(offset) / stepBeats + 0.5);
+            const int step = (int)(((stepCount % numSequencerSteps) + numSequencerSteps) % numSequencerSteps);
+
+            for (int track = 0; track < 4; ++track)
+                if (((sequencerPatterns[(size_t)track].load() >> step) & 1) != 0)
+                    addDrumHit(offset, track);
+
+            sequencerPlayStep.store(step);
+        }
+    }
+    else
+    {
+        sequencerPlayStep.store(-1);
+    }
+
+    updateDrumGains(numSamples);
+
+    int mixedUpTo = 0;
+
+    for (int i = 0; i < numDrumHits; ++i)
+    {
+        const auto& hit = drumHits[(size_t)i];
+        mixDrumVoices(buffer, mixedUpTo, hit.offset - mixedUpTo);
+        mixedUpTo = hit.offset;
+        startDrumVoice(hit.track);
+    }
+
+    mixDrumVoices(buffer, mixedUpTo, numSamples - mixedUpTo);
+}
+
+// Inserts in offset order; hits at the same offset keep the order they were added in.
+void CMProjectAudioProcessor::addDrumHit(int offset, int track) noexcept
+{
+    if (numDrumHits >= (int)drumHits.size())
+        return;
+
+    int i = numDrumHits++;
+
+    for (; i > 0 && drumHits[(size_t)(i - 1)].offset > offset; --i)
+        drumHits[(size_t)i] = drumHits[(size_t)(i - 1)];
+
+    drumHits[(size_t)i] = { offset, track };
+}
+
+// Samples from the start of this block until dueMicros; 0 if it is already past. A time more
+// than a second away means the clock estimate just jumped, so it is played straight away too.
+int CMProjectAudioProcessor::samplesUntilDue(juce::uint32 dueMicros) const noexcept
+{
+    const auto delta = (juce::int32)(dueMicros - blockStartMicros);
+
+    if (delta <= 0 || delta > 1000000)
+        return 0;
+
+    return (int)((double)delta * currentSampleRate * 1.0e-6);
+}
+
+// Timed /handGrain updates and gesture engine output are applied at the block they fall due
+// in; the parameters are smoothed or read once per grain, so finer placement would not be
+// audible. Events from the two queues are merged in due order.
+void CMProjectAudioProcessor::applyDueHandGrains(int numSamples) noexcept
+{
+    auto addPending = [this](const HandGrainEvent& event)
+    {
+        if (numPendingHandGrains == (int)pendingHandGrains.size())
+        {
+            std::move(pendingHandGrains.begin() + 1, pendingHandGrains.end(), pendingHandGrains.begin());
+            --numPendingHandGrains;
+        }
+
+        int index = numPendingHandGrains++;
+
+        for (; index > 0 && (juce::int32)(event.dueMicros - pendingHandGrains[(size_t)index - 1].dueMicros) < 0; --index)
+            pendingHandGrains[(size_t)index] = pendingHandGrains[(size_t)index - 1];
+
+        pendingHandGrains[(size_t)index] = event;
+    };
+
+    HandGrainEvent event;
+
+    while (handGrainEvents.pop(event))
+        addPending(event);
+
+    while (sharedHandGrainEvents.pop(event))
+        addPending(event);
+
+    int numApplied = 0;
+    std::atomic<float>* const parameters[] { &grainDur, &grainPos, &cutoff, &density, &pitch, &reverse };
+
+    while (numApplied < numPendingHandGrains && samplesUntilDue(pendingHandGrains[(size_t)numApplied].dueMicros) < numSamples)
+    {
+        const auto& due = pendingHandGrains[(size_t)numApplied++];
+
+        for (size_t i = 0; i < due.values.size(); ++i)
+            if (((due.mask >> i) & 1) != 0)
+                parameters[i]->store(due.values[i]);
+    }
+
+    std::move(pendingHandGrains.begin() + numApplied, pendingHandGrains.begin() + numPendingHandGrains, pendingHandGrains.begin());
+    numPendingHandGrains -= numApplied;
+}
+
+juce::uint32 CMProjectAudioProcessor::GestureClock::nowMicros() noexcept
+{
+    return (juce::uint32)(juce::int64)(juce::Time::getMillisecondCounterHiRes() * 1000.0);
+}
+
+juce::uint32 CMProjectAudioProcessor::GestureClock::toLocal(juce::uint32 captureMicros, juce::uint32 receivedMicros) noexcept
+{
+    const juce::uint32 difference = receivedMicros - captureMicros;
+    const auto change = (juce::int32)(difference - offset);
+
+    // A jump of over a second means the tracker was restarted: start a fresh estimate.
+    if (! hasEstimate || change > 1000000 || change < -1000000)
+    {
+        hasEstimate = true;
+        offset = difference;
+        windowCount = 0;
+    }
+    else if (change < 0)
+    {
+        offset = difference; // faster than anything seen so far
+    }
+
+    if (windowCount == 0 || (juce::int32)(difference - windowMin) < 0)
+        windowMin = difference;
+
+    if (++windowCount >= windowSize)
+    {
+        offset = windowMin;
+        windowCount = 0;
+    }
+
+    return captureMicros + offset;
+}
+
+// Reads each track volume once per block and turns it into a linear ramp over the block.
+void CMProjectAudioProcessor::updateDrumGains(int numSamples) noexcept
+{
+    for (size_t track = 0; track < 4; ++track)
+    {
+        auto& smoother = smoothedTrackGains[track];
+        smoother.setTargetValue(trackVolumes[track].load());
+
+        drumGainStart[track] = smoother.getCurrentValue();
+        drumGainStep[track] = numSamples > 0 ? (smoother.skip(numSamples) - drumGainStart[track]) / (float)numSamples
+                                             : 0.0f;
+    }
+}
+
+// Each hit is mixed as one contiguous span per channel rather than sample by sample; a gain
+// ramp or declick fade becomes a single addFromWithRamp over the span.
+void CMProjectAudioProcessor::mixDrumVoices(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept
+{
+    const int numChannels = buffer.getNumChannels();
+    const float fadeScale = 1.0f / (float)drumFadeSamples;
+
+    for (auto& voice : drumVoices)
+    {
+        if (! voice.isActive())
+            continue;
+
+        const auto& sample = voice.sample->buffer;
+        const bool fading = voice.fadeRemaining > 0;
+        int numToMix = juce::jmin(numSamples, sample.getNumSamples() - voice.position);
+
+        if (fading)
+            numToMix = juce::jmin(numToMix, voice.fadeRemaining);
+
+        const auto track = (size_t)voice.track;
+        float startGain = drumGainStart[track] + drumGainStep[track] * (float)startSample;
+        float endGain = startGain + drumGainStep[track] * (float)juce::jmax(0, numToMix);
+
+        if (fading)
+        {
+            startGain *= (float)voice.fadeRemaining * fadeScale;
+            endGain *= (float)(voice.fadeRemaining - numToMix) * fadeScale;
+        }
+
+        for (int ch = 0; ch < numChannels && numToMix > 0; ++ch)
+        {
+            const float* in = sample.getReadPointer(juce::jmin(ch, sample.getNumChannels() - 1), voice.position);
+
+            if (startGain != endGain)
+                buffer.addFromWithRamp(ch, startSample, in, numToMix, startGain, endGain);
+            else
+                juce::FloatVectorOperations::addWithMultiply(buffer.getWritePointer(ch, startSample), in, startGain, numToMix);
+        }
+
+        voice.position += juce::jmax(0, numToMix);
+
+        if (fading)
+            voice.fadeRemaining -= juce::jmax(0, numToMix);
+
+        // Dropping the reference here is safe: the release pool still holds the sample.
+        if (voice.position >= sample.getNumSamples() || (fading && voice.fadeRemaining <= 0))
+            voice.sample = nullptr;
+    }
+}
+
+// Only ever called from one thread (the OSC receiver thread), which makes it the single producer
+// of drumTriggers; the audio thread applies the trigger at the start of its next block.
+void CMProjectAudioProcessor::triggerSamplePlayback(int trackIndex)
+{
+    if (trackIndex >= 0 && trackIndex < 4 && ! drumTriggers.push({ trackIndex, false, 0 }))
+        DBG("Drum trigger queue full, dropping trigger for track " << trackIndex);
+}
+
+// Same thread as triggerSamplePlayback; the audio thread places the hit at dueMicros.
+void CMProjectAudioProcessor::scheduleDrumTrigger(int trackIndex, juce::uint32 dueMicros)
+{
+    if (trackIndex >= 0 && trackIndex < 4 && ! drumTriggers.push({ trackIndex, true, dueMicros }))
+        DBG("Drum trigger queue full, dropping trigger for track " << trackIndex);
+}
+
+bool CMProjectAudioProcessor::saveMidiRecording(const juce::File& file)
+{
+    juce::MidiFile midiFile;
+    midiFile.setTicksPerQuarterNote(960);
+    midiFile.addTrack(recordedSequence);
+
+    if (auto stream = file.createOutputStream())
+    {
+        midiFile.writeTo(*stream);
+        return true;
+    }
+    return false;
+}
+
+bool CMProjectAudioProcessor::startAudioRecording()
+{
+    if (currentSampleRate <= 0.0 || getTotalNumOutputChannels() <= 0)
+        return false;
+
+    stopAudioRecording();
+
+    auto tempFile = juce::File::getSpecialLocation(juce::File::tempDirectory)
+                        .getNonexistentChildFile("hand-granulator-take", ".wav");
+
+    auto fileStream = std::unique_ptr<juce::FileOutputStream>(tempFile.createOutputStream());
+
+    if (fileStream == nullptr)
+        return false;
+
+    juce::WavAudioFormat wavFormat;
+    auto* writer = wavFormat.createWriterFor(fileStream.get(),
+                                             currentSampleRate,
+                                             (unsigned int) juce::jmax(1, getTotalNumOutputChannels()),
+                                             24,
+                                             {},
+                                             0);
+
+    if (writer == nullptr)
+        return false;
+
+    fileStream.release();
+
+    auto nextThreadedWriter = std::make_unique<juce::AudioFormatWriter::ThreadedWriter>(writer,
+                                                                                         audioRecordingThread,
+                                                                                         32768);
+
+    {
+        const juce::ScopedLock lock(audioRecordingLock);
+        currentAudioRecordingFile = tempFile;
+        latestAudioRecordingFile = juce::File();
+        threadedAudioWriter = std::move(nextThreadedWriter);
+        activeAudioWriter.store(threadedAudioWriter.get());
+        isRecordingAudio.store(true);
+    }
+
+    return true;
+}
+
+void CMProjectAudioProcessor::stopAudioRecording()
+{
+    const juce::ScopedLock lock(audioRecordingLock);
+
+    activeAudioWriter.store(nullptr);
+    threadedAudioWriter.reset();
+    isRecordingAudio.store(false);
+
+    if (currentAudioRecordingFile.existsAsFile())
+        latestAudioRecordingFile = currentAudioRecordingFile;
 
     currentAudioRecordingFile = juce::File();
 }
@@ -582,61 +1920,1568 @@ juce::File CMProjectAudioProcessor::getLatestAudioRecordingFile() const
     return latestAudioRecordingFile;
 }
 
-void CMProjectAudioProcessor::loadSynthSample(const juce::File& file)
+void CMProjectAudioProcessor::loadSynthSample(const juce::File& file, bool reversed)
+{
+    startSampleLoad(synthConversionSlot, file, reversed);
+}
+
+std::shared_ptr<const CMProjectAudioProcessor::DecodedAudio> CMProjectAudioProcessor::getDecodedSynthSample() const
+{
+    const juce::ScopedLock lock(loadedSampleLock);
+    return decodedSources[(size_t)synthConversionSlot];
+}
+
+// Moving the slot's generation on cancels whatever is still decoding or converting for it.
+// The decode job hands over to a conversion once the whole file is in memory.
+void CMProjectAudioProcessor::startSampleLoad(int slot, const juce::File& file, bool reversed)
+{
+    const juce::ScopedLock lock(loadedSampleLock);
+    const auto generation = ++conversionGenerations[(size_t)slot];
+    decodingSlots[(size_t)slot] = true;
+    loadProgress[(size_t)slot].store(0.0f);
+
+    conversionPool.addJob([this, slot, file, generation, reversed]
+    {
+        auto decoded = decodeAudioFile(file, slot, generation, reversed);
+
+        const juce::ScopedLock jobLock(loadedSampleLock);
+        if (conversionGenerations[(size_t)slot].load() != generation)
+            return;
+
+        decodingSlots[(size_t)slot] = false;
+
+        if (decoded == nullptr)
+        {
+            DBG("Could not decode " << file.getFullPathName());
+            loadProgress[(size_t)slot].store(-1.0f);
+            return;
+        }
+
+        if (slot == synthConversionSlot && decoded->sampleRate > 0.0)
+            synthSampleSeconds.store((float)((double)decoded->buffer.getNumSamples() / decoded->sampleRate));
+
+        decodedSources[(size_t)slot] = std::move(decoded);
+        startSampleConversion(slot);
+    });
+}
+
+// Runs on the conversion pool. Reads in slices so a newer load can cancel it and the editor can show how
+// far it got. Decoding is most of the work unless the file needs converting, in which case
+// it counts for half.
+std::shared_ptr<const CMProjectAudioProcessor::DecodedAudio> CMProjectAudioProcessor::decodeAudioFile(const juce::File& file, int slot,
+                                                                                                      juce::uint32 generation, bool reversed)
 {
+    constexpr int sliceLength = 1 << 16;
+
     std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
     if (reader == nullptr)
+        return nullptr;
+
+    double targetRate = 0.0;
+    {
+        const juce::ScopedLock lock(loadedSampleLock);
+        targetRate = conversionRate;
+    }
+
+    const float decodeShare = targetRate > 0.0 && reader->sampleRate != targetRate ? 0.5f : 1.0f;
+    const int length = (int)reader->lengthInSamples;
+    auto decoded = std::make_shared<DecodedAudio>();
+    decoded->sampleRate = reader->sampleRate;
+    decoded->buffer.setSize((int)reader->numChannels, length);
+
+    for (int start = 0; start < length; start += sliceLength)
+    {
+        if (conversionGenerations[(size_t)slot].load() != generation)
+            return nullptr;
+
+        const int numToRead = juce::jmin(sliceLength, length - start);
+        reader->read(&decoded->buffer, start, numToRead, start, true, true);
+        loadProgress[(size_t)slot].store(decodeShare * (float)(start + numToRead) / (float)length);
+    }
+
+    if (reversed)
+        for (int ch = 0; ch < decoded->buffer.getNumChannels(); ++ch)
+            std::reverse(decoded->buffer.getWritePointer(ch), decoded->buffer.getWritePointer(ch) + length);
+
+    return decoded;
+}
+
+// Called with loadedSampleLock held. Converting to the engine rate, and building the synth
+// pyramid, happen on the conversion pool; the finished sample is handed to the audio thread
+// from there.
+void CMProjectAudioProcessor::startSampleConversion(int slot)
+{
+    auto source = decodedSources[(size_t)slot];
+    if (source == nullptr)
+        return;
+
+    const auto generation = ++conversionGenerations[(size_t)slot];
+    const double targetRate = conversionRate > 0.0 ? conversionRate : source->sampleRate;
+    const float progressStart = juce::jmax(0.0f, loadProgress[(size_t)slot].load());
+    loadProgress[(size_t)slot].store(progressStart);
+
+    conversionPool.addJob([this, slot, source, generation, targetRate, progressStart]
+    {
+        const auto isCancelled = [this, slot, generation] { return conversionGenerations[(size_t)slot].load() != generation; };
+        const auto onProgress = [this, slot, progressStart, &isCancelled] (float fraction)
+        {
+            if (! isCancelled())
+                loadProgress[(size_t)slot].store(progressStart + (1.0f - progressStart) * fraction);
+        };
+        juce::AudioBuffer<float> converted;
+
+        if (rateConverter.convert(*source, targetRate, converted, conversionPool, isCancelled, onProgress))
+            publishConvertedSample(slot, generation, converted);
+    });
+}
+
+void CMProjectAudioProcessor::publishConvertedSample(int slot, juce::uint32 generation, juce::AudioBuffer<float>& converted)
+{
+    if (slot == synthConversionSlot)
+    {
+        SynthSample::Ptr sample = new SynthSample();
+        auto& pyramid = sample->pyramid;
+        pyramid.build(converted);
+
+        const juce::ScopedLock lock(loadedSampleLock);
+        if (conversionGenerations[(size_t)slot].load() != generation)
+            return;
+
+        const auto plainBytes = (double)converted.getNumChannels() * (double)converted.getNumSamples() * sizeof(float);
+        synthSampleMemoryBytes.store(pyramid.getMemoryBytes());
+        synthSampleMemoryRatio.store(plainBytes > 0.0 ? (float)((double)pyramid.getMemoryBytes() / plainBytes) : 0.0f);
+
+        releasePool.add(sample.get());
+        latestSynthSample = sample;
+        publishedSynthSample.store(sample.get(), std::memory_order_release);
+        loadProgress[(size_t)slot].store(-1.0f);
         return;
+    }
+
+    DrumSample::Ptr sample = new DrumSample();
+    sample->buffer = std::move(converted);
 
-    juce::AudioBuffer<float> temp((int)reader->numChannels, (int)reader->lengthInSamples);
-    reader->read(&temp, 0, (int)reader->lengthInSamples, 0, true, true);
+    const juce::ScopedLock lock(loadedSampleLock);
+    if (conversionGenerations[(size_t)slot].load() != generation)
+        return;
 
-    std::scoped_lock lock(synthSampleMutex);
-    synthSample = std::move(temp);
-    synthSampleLoaded = true;
-    activeGrains.clear();
-    samplesUntilNextGrain = 0.0;
+    releasePool.add(sample.get());
+    latestDrumSamples[(size_t)slot] = sample;
+    publishedDrumSamples[(size_t)slot].store(sample.get(), std::memory_order_release);
+    loadProgress[(size_t)slot].store(-1.0f);
 }
 
 void CMProjectAudioProcessor::startManualSynthNote(int noteNumber, float velocity)
 {
-    synthVelocity = juce::jlimit(0.0f, 1.0f, velocity);
-    heldSynthNotes++;
-    const double freq = juce::MidiMessage::getMidiNoteInHertz(noteNumber);
-    currentPitchRatio = (float)(freq / 440.0); // SC: pitchRatio = note.midicps / 440
+    if (! guiNoteEvents.push({ noteNumber, juce::jlimit(0.001f, 1.0f, velocity) }))
+        DBG("Synth note queue full, dropping note " << noteNumber);
 }
 
 void CMProjectAudioProcessor::stopManualSynthNote(int noteNumber)
 {
-    juce::ignoreUnused(noteNumber);
-    heldSynthNotes = juce::jmax(0, heldSynthNotes - 1);
+    if (! guiNoteEvents.push({ noteNumber, 0.0f }))
+        DBG("Synth note queue full, dropping note off " << noteNumber);
 }
 
-void CMProjectAudioProcessor::spawnGrain()
+// Audio thread only, like everything else that touches synthVoices.
+void CMProjectAudioProcessor::synthNoteOn(int noteNumber, float velocity) noexcept
 {
-    if (!synthSampleLoaded || synthSample.getNumSamples() <= 1)
+    for (int v = 0; v < maxSynthVoices; ++v)
+    {
+        if (! synthVoices[(size_t)v].isActive())
+        {
+            startVoice(v, noteNumber, velocity);
+            return;
+        }
+    }
+
+    const int victim = findVoiceToSteal();
+    auto& voice = synthVoices[(size_t)victim];
+
+    // A voice with nothing sounding can be taken over straight away.
+    if (voice.numGrains == 0)
+    {
+        startVoice(victim, noteNumber, velocity);
         return;
+    }
 
-    const int sampleLength = synthSample.getNumSamples();
-    const double sampleDurationSeconds = (double)sampleLength / juce::jmax(1.0, currentSampleRate);
-    const float posSeconds = juce::jlimit(0.0f, (float)sampleDurationSeconds, grainPos.load());
-    const float durSeconds = juce::jlimit(0.005f, 0.5f, grainDur.load());
-    const bool isReverse = reverse.load() >= 0.5f;
+    voice.isHeld = false;
+    voice.pendingNote = noteNumber;
+    voice.pendingVelocity = velocity;
 
-    // SC behavior: playbackRate = basePitchRatio * shiftFactor * wheelFactor
-    const float shiftSemitones = juce::jlimit(-24.0f, 24.0f, pitch.load());
-    const float wheelSemitones = juce::jlimit(-2.0f, 2.0f, pitchWheelSemitones);
-    const double shiftFactor = std::pow(2.0, shiftSemitones / 12.0);
-    const double wheelFactor = std::pow(2.0, wheelSemitones / 12.0);
-    const double rate = (double)currentPitchRatio * shiftFactor * wheelFactor;
+    if (voice.fadeRemaining == 0)
+        voice.fadeRemaining = stealFadeSamples;
+}
 
-    Grain grain;
-    grain.totalSamples = juce::jmax(16, (int)std::round(durSeconds * (float)currentSampleRate));
-    grain.remainingSamples = grain.totalSamples;
-    grain.sampleStep = isReverse ? -rate : rate;
-    grain.samplePos = juce::jlimit(0.0, (double)(sampleLength - 1), posSeconds * currentSampleRate);
-    grain.gain = juce::jlimit(0.02f, 1.0f, synthVelocity * 0.2f);
-    grain.lowpassState = 0.0f;
+void CMProjectAudioProcessor::synthNoteOff(int noteNumber) noexcept
+{
+    for (auto& voice : synthVoices)
+    {
+        if (voice.isHeld && voice.noteNumber == noteNumber)
+            voice.isHeld = false;
 
-    activeGrains.push_back(grain);
+        if (voice.pendingNote == noteNumber)
+            voice.pendingNote = -1;
+    }
+}
+
+void CMProjectAudioProcessor::startVoice(int voiceIndex, int noteNumber, float velocity) noexcept
+{
+    auto& voice = synthVoices[(size_t)voiceIndex];
+    jassert(voice.numGrains == 0);
+
+    voice.noteNumber = noteNumber;
+    voice.velocity = juce::jlimit(0.0f, 1.0f, velocity);
+    voice.pitchRatio = (float)(juce::MidiMessage::getMidiNoteInHertz(noteNumber) / 440.0); // SC: pitchRatio = note.midicps / 440
+    voice.isHeld = true;
+    voice.startOrder = nextVoiceOrder++;
+    voice.triggerOnStart = true;
+    voice.level = 0.0f;
+    voice.fadeRemaining = 0;
+    voice.pendingNote = -1;
+    voice.filter.reset();
+}
+
+// Voices that are only ringing out go first, then held voices; voices already fading for
+// another note go last, since stealing those drops the newer note. Within a rank the
+// steal mode picks the oldest or the quietest.
+int CMProjectAudioProcessor::findVoiceToSteal() const noexcept
+{
+    auto rank = [](const SynthVoice& voice)
+    {
+        if (voice.fadeRemaining > 0)
+            return 0;
+
+        return voice.isHeld ? 1 : 2;
+    };
+
+    const bool quietest = voiceStealMode.load() == stealQuietestVoice;
+    int best = 0;
+
+    for (int v = 1; v < maxSynthVoices; ++v)
+    {
+        const auto& candidate = synthVoices[(size_t)v];
+        const auto& current = synthVoices[(size_t)best];
+
+        if (rank(candidate) != rank(current))
+        {
+            if (rank(candidate) > rank(current))
+                best = v;
+
+            continue;
+        }
+
+        const bool better = quietest ? candidate.level < current.level
+                                     : (juce::int32)(candidate.startOrder - current.startOrder) < 0;
+
+        if (better)
+            best = v;
+    }
+
+    return best;
+}
+
+void CMProjectAudioProcessor::retireGrain(int index) noexcept
+{
+    --synthVoices[(size_t)grainPool.voice[(size_t)index]].numGrains;
+    grainPool.swapRemove(index);
+}
+
+// Drops every grain, e.g. after the sample changed. Held notes keep playing on the new sample
+// and a voice that was fading for a steal hands over to its pending note at once.
+void CMProjectAudioProcessor::resetSynthVoices() noexcept
+{
+    grainPool.clear();
+
+    for (int v = 0; v < maxSynthVoices; ++v)
+    {
+        auto& voice = synthVoices[(size_t)v];
+        voice.numGrains = 0;
+        voice.filter.reset();
+
+        if (voice.fadeRemaining > 0)
+        {
+            voice.fadeRemaining = 0;
+
+            if (voice.pendingNote >= 0)
+                startVoice(v, voice.pendingNote, voice.pendingVelocity);
+        }
+    }
+}
+
+bool CMProjectAudioProcessor::hasActiveSynthVoices() const noexcept
+{
+    for (const auto& voice : synthVoices)
+        if (voice.isActive())
+            return true;
+
+    return false;
+}
+
+void CMProjectAudioProcessor::ParameterRamp::advance(float newTarget, float coefficient) noexcept
+{
+    start = end;
+    target = newTarget;
+    end += coefficient * (target - end);
+
+    // Settle exactly, so a parameter at rest costs nothing downstream
+    if (std::abs(target - end) <= 1.0e-4f * (1.0f + std::abs(target)))
+        end = target;
+}
+
+// Reads every grain parameter once for the block. With numSamples = 0 (from prepareToPlay)
+// the ramps jump straight to the current values.
+void CMProjectAudioProcessor::updateGrainRamps(int numSamples) noexcept
+{
+    const std::array<float, numGrainRamps> targets {
+        juce::jlimit(0.005f, (float)maxGrainSeconds, grainDur.load()),
+        juce::jmax(0.0f, grainPos.load()),
+        juce::jmax(0.01f, density.load()),
+        juce::jlimit(-24.0f, 24.0f, pitch.load()),
+        reverse.load() >= 0.5f ? 1.0f : 0.0f,
+        std::log2(juce::jlimit(20.0f, 20000.0f, cutoff.load()))
+    };
+
+    // Time constants: a little over one camera frame, shorter for the reverse cross-fade
+    constexpr std::array<float, numGrainRamps> timeConstants { 0.04f, 0.04f, 0.04f, 0.03f, 0.02f, 0.03f };
+    const float blockSeconds = (float)numSamples / (float)juce::jmax(1.0, currentSampleRate);
+
+    for (size_t p = 0; p < grainRamps.size(); ++p)
+    {
+        if (numSamples <= 0)
+            grainRamps[p].reset(targets[p]);
+        else
+            grainRamps[p].advance(targets[p], 1.0f - std::exp(-blockSeconds / timeConstants[p]));
+    }
+
+    grainRampScale = 1.0f / (float)juce::jmax(1, numSamples);
+}
+
+bool CMProjectAudioProcessor::spawnGrain(int voiceIndex, int sampleInBlock, bool isReverse, float gainScale)
+{
+    if (activeSynthSample == nullptr || activeSynthSample->pyramid.getLevelLength(0) <= 1)
+        return false;
+
+    const auto& synthPyramid = activeSynthSample->pyramid;
+
+    auto& voice = synthVoices[(size_t)voiceIndex];
+
+    // Hard grain budget, shared evenly between the voices that are sounding so one dense
+    // note cannot starve the rest of a chord.
+    const int budget = juce::jmin(grainBudget.load(), grainPool.capacity());
+    int numSounding = 0;
+
+    // A voice only ringing out its filter tail spawns nothing, so it takes no share.
+    for (const auto& other : synthVoices)
+        numSounding += (other.isHeld || other.numGrains > 0) ? 1 : 0;
+
+    if (grainPool.size() >= budget || voice.numGrains >= juce::jmax(1, budget / juce::jmax(1, numSounding)))
+        return false;
+
+    const int sampleLength = synthPyramid.getLevelLength(0);
+    const double sampleDurationSeconds = (double)sampleLength / juce::jmax(1.0, currentSampleRate);
+    const float posSeconds = juce::jlimit(0.0f, (float)sampleDurationSeconds, grainRampAt(positionRamp, sampleInBlock));
+    const float durSeconds = grainRampAt(durationRamp, sampleInBlock);
+
+    // SC behavior: playbackRate = basePitchRatio * shiftFactor * wheelFactor
+    const float shiftSemitones = grainRampAt(pitchRamp, sampleInBlock);
+    const float wheelSemitones = juce::jlimit(-2.0f, 2.0f, pitchWheelSemitones);
+    const double shiftFactor = std::pow(2.0, shiftSemitones / 12.0);
+    const double wheelFactor = std::pow(2.0, wheelSemitones / 12.0);
+    const double rate = (double)voice.pitchRatio * shiftFactor * wheelFactor;
+
+    Grain grain;
+    grain.totalSamples = juce::jmax(16, (int)std::round(durSeconds * (float)currentSampleRate));
+    grain.remainingSamples = grain.totalSamples;
+    grain.sampleStep = isReverse ? -rate : rate;
+    grain.samplePos = juce::jlimit(0.0, (double)(sampleLength - 1), posSeconds * currentSampleRate);
+    grain.gain = juce::jlimit(0.02f, 1.0f, voice.velocity * 0.2f) * gainScale;
+    grain.voice = voiceIndex;
+    grain.windowOffset = grainWindows.getOffset(windowShape.load(), windowTaper.load());
+
+    // Read the octave level that brings the step back to at most one sample.
+    const int level = synthPyramid.getLevelForStep(rate);
+    const double levelScale = 1.0 / (double)(1 << level);
+    grain.sourceOffset = synthPyramid.getLevelOffset(level);
+    grain.sourceLength = synthPyramid.getLevelLength(level);
+    grain.sampleStep *= levelScale;
+    grain.samplePos = juce::jlimit(0.0, (double)(grain.sourceLength - 1), grain.samplePos * levelScale);
+
+    if (! grainPool.spawn(grain))
+        return false;
+
+    ++voice.numGrains;
+    return true;
+}
+
+// Grain-major renderer: the block's trigger offsets are worked out up front, then every grain
+// is rendered across its whole active span in one pass instead of revisiting all grains per sample.
+// Each voice sums its grains into its own slice of voiceMix, which is filtered, faded if the
+// voice is being stolen, and added to the output. numSamples must not exceed voiceMix's size.
+void CMProjectAudioProcessor::renderGranularBlock(juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+    const float densityValue = grainRampAt(densityRamp, startSample);
+    const double beatsPerSecond = transportClock.ppqPerSample * currentSampleRate;
+    // Match SC: trigRate = ((bpm / 60) * 4 * density).max(0.1), here as a grid in beats
+    // capped so the grain pool sized in prepareToPlay always has room
+    const double grainsPerSecond = juce::jlimit(0.1, maxGrainRateHz, beatsPerSecond * 4.0 * (double)densityValue);
+    const double gridBeats = juce::jmax(transportClock.ppqPerSample, beatsPerSecond / grainsPerSecond);
+    const bool useVoiceFilter = grainFilterMode.load() == voiceFilter;
+    const int numOutputs = juce::jmin(buffer.getNumChannels(), maxRenderChannels);
+
+    // Cutoff at the start of this chunk, and the per-sample factor that follows its ramp
+    const auto& cutoffOctaves = grainRamps[cutoffRamp];
+    const float chunkCutoff = std::exp2(grainRampAt(cutoffRamp, startSample));
+    const float cutoffStepFactor = std::exp2((cutoffOctaves.end - cutoffOctaves.start) * grainRampScale);
+
+    float* outputs[maxSynthVoices * maxRenderChannels] {};
+    std::array<bool, maxSynthVoices> voiceActive {};
+
+    for (int v = 0; v < maxSynthVoices; ++v)
+    {
+        // Filter tails only ring on while the voice filter is running
+        if (! useVoiceFilter)
+            synthVoices[(size_t)v].filter.reset();
+
+        voiceActive[(size_t)v] = synthVoices[(size_t)v].isActive();
+
+        for (int ch = 0; ch < numOutputs; ++ch)
+        {
+            auto*& output = outputs[v * maxRenderChannels + ch];
+            output = voiceMix.getWritePointer(v * maxRenderChannels + ch);
+
+            if (voiceActive[(size_t)v])
+                juce::FloatVectorOperations::clear(output, numSamples);
+        }
+    }
+
+    // Without the voice filter each grain runs its own one-pole instead.
+    float lowpassAlpha = 1.0f;
+
+    if (! useVoiceFilter)
+    {
+        const double dt = 1.0 / juce::jmax(1.0, currentSampleRate);
+        const double rc = 1.0 / (2.0 * juce::MathConstants<double>::pi * std::exp2(grainRampAt(cutoffRamp, startSample + numSamples)));
+        lowpassAlpha = (float)juce::jlimit(0.0, 1.0, dt / (rc + dt));
+    }
+
+    GrainRenderContext context;
+    context.source = activeSynthSample->pyramid.getArrayOfReadPointers();
+    context.sourceChannels = activeSynthSample->pyramid.getNumChannels();
+    context.outputs = outputs;
+    context.numOutputs = numOutputs;
+    context.lowpassAlpha = lowpassAlpha;
+    context.windows = grainWindows.data();
+    context.sincTable = sincTable.data();
+    context.interpolation = (isNonRealtime() ? offlineInterpolation : liveInterpolation).load();
+
+    // Grains that were already sounding cover the block from sample 0. Whole batches of
+    // grains that outlive the block go through the SIMD kernel, everything else through the
+    // scalar renderGrain, which remains the reference implementation.
+    const int numBatched = renderGrainBatches(numSamples, context);
+
+    for (int g = grainPool.size() - 1; g >= 0; --g)
+    {
+        if (numBatched > 0 && grainBatched[(size_t)g] != 0)
+        {
+            if (grainPool.remainingSamples[(size_t)g] <= 0)
+                retireGrain(g);
+
+            continue;
+        }
+
+        if (! renderGrain(g, 0, numSamples, context))
+            retireGrain(g);
+    }
+
+    // Every held voice fires on the same beat grid; a note that has just started also gets a
+    // grain straight away rather than waiting up to a grid step for its first one.
+    const int numTriggers = transportClock.findGridTriggers(startSample, numSamples, gridBeats,
+                                                        gridTriggers.data(), (int)gridTriggers.size());
+
+    for (int v = 0; v < maxSynthVoices; ++v)
+    {
+        auto& voice = synthVoices[(size_t)v];
+
+        if (! voice.isHeld)
+            continue;
+
+        const bool firesOnStart = voice.triggerOnStart;
+        voice.triggerOnStart = false;
+
+        for (int t = firesOnStart ? -1 : 0; t < numTriggers; ++t)
+        {
+            const int offset = t < 0 ? 0 : gridTriggers[(size_t)t];
+
+            if (t >= 0 && firesOnStart && offset == 0)
+                continue;
+
+            auto spawnAndRender = [&](bool isReverse, float gainScale)
+            {
+                if (! spawnGrain(v, startSample + offset, isReverse, gainScale))
+                    return; // over budget: drop this trigger
+
+                const int newest = grainPool.size() - 1;
+
+                if (! renderGrain(newest, offset, numSamples, context))
+                    retireGrain(newest);
+            };
+
+            // While reverse is switching, each trigger fires a forward and a reverse grain
+            // with equal-power gains instead of flipping direction mid-stream.
+            const float reverseMix = grainRampAt(reverseRamp, startSample + offset);
+
+            if (reverseMix < 0.001f)
+                spawnAndRender(false, 1.0f);
+            else if (reverseMix > 0.999f)
+                spawnAndRender(true, 1.0f);
+            else
+            {
+                spawnAndRender(false, std::sqrt(1.0f - reverseMix));
+                spawnAndRender(true, std::sqrt(reverseMix));
+            }
+        }
+    }
+
+    if (useVoiceFilter)
+    {
+        if (cutoffOctaves.isMoving())
+        {
+            // The cutoff glides at audio rate; one set of coefficients per sample serves every voice.
+            float sampleCutoff = chunkCutoff;
+
+            for (int i = 0; i < numSamples; ++i, sampleCutoff *= cutoffStepFactor)
+            {
+                const auto coefficients = VoiceFilter::makeLowpass(sampleCutoff, currentSampleRate);
+
+                for (int v = 0; v < maxSynthVoices; ++v)
+                    if (voiceActive[(size_t)v])
+                        for (int ch = 0; ch < numOutputs; ++ch)
+                        {
+                            auto& sample = outputs[v * maxRenderChannels + ch][i];
+                            sample = synthVoices[(size_t)v].filter.processSample(ch, sample, coefficients);
+                        }
+            }
+        }
+        else
+        {
+            const auto coefficients = VoiceFilter::makeLowpass(chunkCutoff, currentSampleRate);
+
+            for (int v = 0; v < maxSynthVoices; ++v)
+                if (voiceActive[(size_t)v])
+                    for (int ch = 0; ch < numOutputs; ++ch)
+                    {
+                        auto* samples = outputs[v * maxRenderChannels + ch];
+
+                        for (int i = 0; i < numSamples; ++i)
+                            samples[i] = synthVoices[(size_t)v].filter.processSample(ch, samples[i], coefficients);
+                    }
+        }
+    }
+
+    for (int v = 0; v < maxSynthVoices; ++v)
+    {
+        if (! voiceActive[(size_t)v])
+            continue;
+
+        auto& voice = synthVoices[(size_t)v];
+        voice.level = 0.0f;
+
+        for (int ch = 0; ch < numOutputs; ++ch)
+            voice.level = juce::jmax(voice.level, voiceMix.getMagnitude(v * maxRenderChannels + ch, 0, numSamples));
+
+        if (voice.fadeRemaining <= 0)
+        {
+            for (int ch = 0; ch < numOutputs; ++ch)
+                buffer.addFrom(ch, startSample, voiceMix, v * maxRenderChannels + ch, 0, numSamples);
+
+            continue;
+        }
+
+        // Stolen: ramp out, then drop what is left of the old note and start the new one.
+        const int numFading = juce::jmin(numSamples, voice.fadeRemaining);
+        const float fadeScale = 1.0f / (float)stealFadeSamples;
+        const float startGain = (float)voice.fadeRemaining * fadeScale;
+        const float endGain = (float)(voice.fadeRemaining - numFading) * fadeScale;
+
+        for (int ch = 0; ch < numOutputs; ++ch)
+            buffer.addFromWithRamp(ch, startSample, outputs[v * maxRenderChannels + ch], numFading, startGain, endGain);
+
+        voice.fadeRemaining -= numFading;
+
+        if (voice.fadeRemaining > 0)
+            continue;
+
+        for (int g = grainPool.size() - 1; g >= 0; --g)
+            if (grainPool.voice[(size_t)g] == v)
+                retireGrain(g);
+
+        if (voice.pendingNote >= 0)
+            startVoice(v, voice.pendingNote, voice.pendingVelocity);
+        else
+            voice.filter.reset();
+    }
+}
+
+void CMProjectAudioProcessor::handleSynthMidi(const juce::MidiMessage& msg) noexcept
+{
+    if (msg.isNoteOn())
+    {
+        auto note = msg.getNoteNumber(); // 0–127
+        auto vel = msg.getVelocity() / 127.0f; // normalized 0.0–1.0
+        synthNoteOn(note, vel);
+    }
+    else if (msg.isNoteOff())
+    {
+        auto note = msg.getNoteNumber();
+        synthNoteOff(note);
+    }
+    else if (msg.isPitchWheel())
+    {
+        const int raw = msg.getPitchWheelValue();
+        const float norm = (raw - 8192) / 8192.0f; // -1..+1
+        pitchWheelSemitones = norm * 2.0f;         // SC behavior: +-2 semitones
+    }
+}
+
+// Renders the synth over part of the block.
+void CMProjectAudioProcessor::renderSynthRange(juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+    if (numSamples <= 0 || activeSynthSample == nullptr || activeSynthSample->pyramid.getLevelLength(0) <= 1
+        || voiceMix.getNumSamples() <= 0 || ! hasActiveSynthVoices())
+        return;
+
+    // Hosts may send blocks larger than announced in prepareToPlay, so render in chunks
+    // that fit the voice mix buffer.
+    const int maxChunk = voiceMix.getNumSamples();
+
+    for (int offset = 0; offset < numSamples; offset += maxChunk)
+        renderGranularBlock(buffer, startSample + offset, juce::jmin(maxChunk, numSamples - offset));
+}
+
+// Reads the host transport for this block. The free-running clock follows the host while it
+// plays, so stopping the transport carries on from the same beat position.
+void CMProjectAudioProcessor::updateTransportClock(int numSamples)
+{
+    double bpm = (double)currentBpm.load();
+    bool hostIsPlaying = false;
+    TransportClock clock;
+
+    if (auto* playHead = getPlayHead())
+    {
+        if (auto position = playHead->getPosition())
+        {
+            if (auto hostBpm = position->getBpm())
+                bpm = *hostBpm;
+
+            if (auto ppq = position->getPpqPosition(); ppq && position->getIsPlaying())
+            {
+                hostIsPlaying = true;
+                clock.ppqAtBlockStart = *ppq;
+            }
+
+            if (auto loop = position->getLoopPoints(); loop && position->getIsLooping())
+            {
+                clock.isLooping = loop->ppqEnd > loop->ppqStart;
+                clock.loopStart = loop->ppqStart;
+                clock.loopEnd = loop->ppqEnd;
+            }
+        }
+    }
+
+    clock.ppqPerSample = juce::jmax(1.0, bpm) / (60.0 * juce::jmax(1.0, currentSampleRate));
+
+    if (! hostIsPlaying)
+    {
+        clock.ppqAtBlockStart = freeRunningPpq;
+        clock.isLooping = false;
+    }
+
+    transportClock = clock;
+    freeRunningPpq = clock.ppqAt(numSamples);
+}
+
+double CMProjectAudioProcessor::TransportClock::ppqAt(int sampleInBlock) const noexcept
+{
+    const double ppq = ppqAtBlockStart + (double)sampleInBlock * ppqPerSample;
+
+    if (isLooping && ppqAtBlockStart < loopEnd && ppq >= loopEnd)
+        return loopStart + std::fmod(ppq - loopEnd, loopEnd - loopStart);
+
+    return ppq;
+}
+
+// Fills offsets (relative to startSample) with the samples where the clock crosses a multiple
+// of gridBeats, splitting the chunk where a host loop wraps. Grid points go to the nearest
+// sample, so a host position that drifts by a fraction of a sample between blocks neither
+// repeats nor skips a trigger.
+int CMProjectAudioProcessor::TransportClock::findGridTriggers(int startSample, int numSamples, double gridBeats,
+                                                              int* offsets, int maxOffsets) const noexcept
+{
+    if (numSamples <= 0 || gridBeats <= 0.0 || ppqPerSample <= 0.0)
+        return 0;
+
+    int numFound = 0;
+
+    // Collects grid points in [fromPpq, toPpq), placing each relative to a reference point
+    // where the clock reads originPpq at (possibly fractional) sample originSample.
+    auto scan = [&](double fromPpq, double toPpq, double originSample, double originPpq)
+    {
+        for (double k = std::ceil(fromPpq / gridBeats); numFound < maxOffsets; k += 1.0)
+        {
+            const double gridPpq = k * gridBeats;
+            const int offset = (int)std::floor(originSample + (gridPpq - originPpq) / ppqPerSample + 0.5);
+
+            if (gridPpq >= toPpq || offset >= numSamples)
+                break;
+
+            offsets[numFound++] = juce::jmax(0, offset);
+        }
+    };
+
+    const double chunkPpq = ppqAt(startSample);
+    const double halfSample = 0.5 * ppqPerSample;
+    const double noLimit = std::numeric_limits<double>::max();
+
+    if (isLooping && chunkPpq < loopEnd && chunkPpq + (double)numSamples * ppqPerSample > loopEnd)
+    {
+        scan(chunkPpq - halfSample, loopEnd, 0.0, chunkPpq);
+        scan(loopStart, noLimit, (loopEnd - chunkPpq) / ppqPerSample, loopStart);
+    }
+    else
+    {
+        scan(chunkPpq - halfSample, noLimit, 0.0, chunkPpq);
+    }
+
+    return numFound;
+}
+
+static int samplesUntilSourceEdge(double samplePos, double sampleStep, int sourceLength) noexcept;
+
+int CMProjectAudioProcessor::renderGrainBatches(int numSamples, const GrainRenderContext& context) noexcept
+{
+    const int width = getGrainKernelWidth(grainKernel);
+
+    // The SIMD kernel implements the linear (draft) tier only.
+    if (width <= 1 || numSamples <= 0 || context.interpolation != linearInterpolation)
+        return 0;
+
+    // Only grains whose span covers the whole block are batched, so every lane runs the
+    // same number of samples and no lane needs a mask. The lanes are summed into a single
+    // output, so a batch only ever holds grains of one voice.
+    std::array<int, maxSynthVoices> numEligible {};
+    int numEligibleBatches = 0;
+
+    for (int g = 0; g < grainPool.size(); ++g)
+    {
+        const auto slot = (size_t)g;
+        const bool fullSpan = grainPool.remainingSamples[slot] >= numSamples
+            && samplesUntilSourceEdge(grainPool.samplePos[slot], grainPool.sampleStep[slot], grainPool.sourceLength[slot]) >= numSamples;
+
+        grainBatched[slot] = fullSpan ? 1 : 0;
+
+        if (fullSpan && ++numEligible[(size_t)grainPool.voice[slot]] % width == 0)
+            ++numEligibleBatches;
+    }
+
+    if (numEligibleBatches == 0)
+    {
+        std::fill(grainBatched.begin(), grainBatched.end(), (juce::uint8)0);
+        return 0;
+    }
+
+    GrainKernelArgs args;
+    const float* sources[maxRenderChannels] {};
+    args.numOutputs = juce::jmin(context.numOutputs, maxRenderChannels);
+
+    for (int ch = 0; ch < args.numOutputs; ++ch)
+        sources[ch] = context.source[juce::jmin(ch, context.sourceChannels - 1)];
+
+    args.sources = sources;
+    args.numSamples = numSamples;
+    args.lowpassAlpha = context.lowpassAlpha;
+    args.windows = context.windows;
+
+    GrainLanes lanes;
+    int slots[maxGrainLanes] {};
+    int numBatched = 0;
+
+    for (int v = 0; v < maxSynthVoices; ++v)
+    {
+        const int numForVoice = numEligible[(size_t)v] - (numEligible[(size_t)v] % width);
+        int numInLanes = 0;
+        int numAssigned = 0;
+
+        if (numEligible[(size_t)v] == 0)
+            continue;
+
+        args.outputs = context.outputs + v * maxRenderChannels;
+
+        for (int g = 0; g < grainPool.size(); ++g)
+        {
+            const auto slot = (size_t)g;
+
+            if (grainBatched[slot] == 0 || grainPool.voice[slot] != v)
+                continue;
+
+            // The remainder that does not fill a whole batch goes back to the scalar path.
+            if (numAssigned == numForVoice)
+            {
+                grainBatched[slot] = 0;
+                continue;
+            }
+
+            const double samplePos = grainPool.samplePos[slot];
+            const double sampleStep = grainPool.sampleStep[slot];
+            const double stepFloor = std::floor(sampleStep);
+            const double posFloor = std::floor(samplePos);
+
+            const int sourceOffset = grainPool.sourceOffset[slot];
+            lanes.index[numInLanes] = sourceOffset + (int)posFloor;
+            lanes.firstIndex[numInLanes] = sourceOffset;
+            lanes.lastIndex[numInLanes] = sourceOffset + juce::jmax(0, grainPool.sourceLength[slot] - 2);
+            lanes.frac[numInLanes] = (float)(samplePos - posFloor);
+            lanes.stepInt[numInLanes] = (int)stepFloor;
+            lanes.stepFrac[numInLanes] = (float)(sampleStep - stepFloor);
+            lanes.windowOffset[numInLanes] = grainPool.windowOffset[slot];
+            lanes.windowPhase[numInLanes] = grainPool.windowPhase[slot];
+            lanes.windowPhaseInc[numInLanes] = grainPool.windowPhaseInc[slot];
+            lanes.gain[numInLanes] = grainPool.gain[slot];
+
+            for (int ch = 0; ch < args.numOutputs; ++ch)
+                lanes.lowpass[ch][numInLanes] = grainPool.lowpassState[(size_t)ch][slot];
+
+            slots[numInLanes++] = g;
+            ++numAssigned;
+
+            if (numInLanes < width)
+                continue;
+
+           #if JUCE_INTEL
+            if (grainKernel == GrainKernel::avx2)
+                renderGrainLanesAVX2(lanes, args);
+            else
+                renderGrainLanesSSE2(lanes, args);
+           #endif
+
+            for (int lane = 0; lane < numInLanes; ++lane)
+            {
+                const auto laneSlot = (size_t)slots[lane];
+                auto& remaining = grainPool.remainingSamples[laneSlot];
+                auto& pos = grainPool.samplePos[laneSlot];
+                const int samplesInSource = samplesUntilSourceEdge(pos, grainPool.sampleStep[laneSlot], grainPool.sourceLength[laneSlot]);
+
+                // Positions are advanced in double here rather than read back from the float lanes,
+                // so batched grains stay sample-locked to the scalar reference.
+                pos += grainPool.sampleStep[laneSlot] * (double)numSamples;
+                remaining -= numSamples;
+                grainPool.windowPhase[laneSlot] += grainPool.windowPhaseInc[laneSlot] * (juce::uint32)numSamples;
+
+                if (samplesInSource == numSamples)
+                    remaining = 0;
+
+                for (int ch = 0; ch < args.numOutputs; ++ch)
+                    grainPool.lowpassState[(size_t)ch][laneSlot] = lanes.lowpass[ch][lane];
+            }
+
+            numInLanes = 0;
+        }
+
+        numBatched += numForVoice;
+    }
+
+    return numBatched;
+}
+
+CMProjectAudioProcessor::GrainKernel CMProjectAudioProcessor::detectGrainKernel() noexcept
+{
+   #if JUCE_INTEL
+    if (juce::SystemStats::hasAVX2())
+        return GrainKernel::avx2;
+
+    if (juce::SystemStats::hasSSE2())
+        return GrainKernel::sse2;
+   #endif
+
+    return GrainKernel::scalar;
+}
+
+int CMProjectAudioProcessor::getGrainKernelWidth(GrainKernel kernel) noexcept
+{
+    switch (kernel)
+    {
+        case GrainKernel::avx2: return 8;
+        case GrainKernel::sse2: return 4;
+        case GrainKernel::scalar: break;
+    }
+
+    return 1;
+}
+
+// Number of samples a grain can render before its read position leaves [0, sourceLength - 1].
+static int samplesUntilSourceEdge(double samplePos, double sampleStep, int sourceLength) noexcept
+{
+    const double lastIndex = (double)(sourceLength - 1);
+    double count = std::numeric_limits<int>::max();
+
+    if (sampleStep > 0.0)
+        count = std::ceil((lastIndex - samplePos) / sampleStep);
+    else if (sampleStep < 0.0)
+        count = std::floor(samplePos / -sampleStep) + 1.0;
+
+    return (int)juce::jlimit(1.0, (double)std::numeric_limits<int>::max(), count);
+}
+
+bool CMProjectAudioProcessor::renderGrain(int index, int startOffset, int endOffset,
+                                          const GrainRenderContext& context) noexcept
+{
+    const auto slot = (size_t)index;
+    int remaining = grainPool.remainingSamples[slot];
+
+    GrainSpan grain;
+    grain.samplePos = grainPool.samplePos[slot];
+    grain.sampleStep = grainPool.sampleStep[slot];
+    grain.gain = grainPool.gain[slot];
+    grain.window = context.windows + grainPool.windowOffset[slot];
+    grain.windowPhase = grainPool.windowPhase[slot];
+    grain.windowPhaseInc = grainPool.windowPhaseInc[slot];
+
+    const int sourceOffset = grainPool.sourceOffset[slot];
+    const int sourceLength = grainPool.sourceLength[slot];
+    const int samplesInSource = samplesUntilSourceEdge(grain.samplePos, grain.sampleStep, sourceLength);
+    const int numToRender = juce::jmin(endOffset - startOffset, remaining, samplesInSource);
+    const int numOutputs = juce::jmin(context.numOutputs, maxRenderChannels);
+    float* const* outputs = context.outputs + grainPool.voice[slot] * maxRenderChannels;
+
+    const float* sources[maxRenderChannels] {};
+    for (int ch = 0; ch < numOutputs; ++ch)
+    {
+        sources[ch] = context.source[juce::jmin(ch, context.sourceChannels - 1)] + sourceOffset;
+        grain.lowpass[ch] = grainPool.lowpassState[(size_t)ch][slot];
+    }
+
+    switch (context.interpolation)
+    {
+        case sincInterpolation:
+        {
+            // Narrower kernels for grains transposed up, so they don't alias
+            const auto* table = context.sincTable + PolyphaseSincTable::getBand(grain.sampleStep) * PolyphaseSincTable::bandStride;
+            renderGrainSpan(grain, SincInterpolator { table }, sources, outputs, numOutputs,
+                            startOffset, numToRender, sourceLength, context.lowpassAlpha);
+            break;
+        }
+
+        case hermiteInterpolation:
+            renderGrainSpan(grain, HermiteInterpolator {}, sources, outputs, numOutputs,
+                            startOffset, numToRender, sourceLength, context.lowpassAlpha);
+            break;
+
+        case linearInterpolation:
+        default:
+            renderGrainSpan(grain, LinearInterpolator {}, sources, outputs, numOutputs,
+                            startOffset, numToRender, sourceLength, context.lowpassAlpha);
+            break;
+    }
+
+    remaining -= numToRender;
+
+    if (numToRender == samplesInSource)
+        remaining = 0; // stepped off the end of the sample
+
+    grainPool.remainingSamples[slot] = remaining;
+    grainPool.samplePos[slot] = grain.samplePos;
+
+    for (int ch = 0; ch < numOutputs; ++ch)
+        grainPool.lowpassState[(size_t)ch][slot] = grain.lowpass[ch];
+
+    grainPool.windowPhase[slot] = grain.windowPhase;
+    return remaining > 0;
+}
+
+// Times every interpolation tier on a fixed synthetic cloud (32 grains at assorted
+// transpositions reading stereo noise) through the same scalar span renderer the audio
+// thread uses, so the tiers can be compared on the machine the plugin is running on.
+void CMProjectAudioProcessor::measureInterpolationCosts()
+{
+    constexpr int numGrains = 32;
+    constexpr int numRepeats = 4;
+    constexpr int sourceLength = 1 << 16;
+    constexpr int numSamples = 512;
+
+    juce::AudioBuffer<float> source(maxRenderChannels, sourceLength);
+    juce::AudioBuffer<float> output(maxRenderChannels, numSamples);
+    juce::Random random(0x5eed);
+
+    for (int ch = 0; ch < source.getNumChannels(); ++ch)
+        for (int i = 0; i < sourceLength; ++i)
+            source.setSample(ch, i, random.nextFloat() * 2.0f - 1.0f);
+
+    const float* sources[maxRenderChannels] { source.getReadPointer(0), source.getReadPointer(1) };
+
+    for (int mode = 0; mode < numInterpolationModes; ++mode)
+    {
+        output.clear();
+        const auto startTicks = juce::Time::getHighResolutionTicks();
+
+        for (int repeat = 0; repeat < numRepeats; ++repeat)
+        {
+            for (int g = 0; g < numGrains; ++g)
+            {
+                GrainSpan grain;
+                grain.samplePos = 1000.0 + 1500.0 * g;
+                grain.sampleStep = std::pow(2.0, (double)(g % 9 - 4) * 0.5);
+                grain.gain = 0.2f;
+                grain.window = grainWindows.data();
+                grain.windowPhaseInc = GrainWindowBank::getPhaseIncrement(numSamples);
+
+                if (mode == sincInterpolation)
+                    renderGrainSpan(grain, SincInterpolator { sincTable.data(grain.sampleStep) }, sources, output.getArrayOfWritePointers(),
+                                    maxRenderChannels, 0, numSamples, sourceLength, 1.0f);
+                else if (mode == hermiteInterpolation)
+                    renderGrainSpan(grain, HermiteInterpolator {}, sources, output.getArrayOfWritePointers(),
+                                    maxRenderChannels, 0, numSamples, sourceLength, 1.0f);
+                else
+                    renderGrainSpan(grain, LinearInterpolator {}, sources, output.getArrayOfWritePointers(),
+                                    maxRenderChannels, 0, numSamples, sourceLength, 1.0f);
+            }
+        }
+
+        const auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+        const auto grainSamples = (double)numRepeats * numGrains * numSamples;
+        interpolationCostNs[(size_t)mode].store((float)(seconds * 1.0e9 / grainSamples));
+    }
+}
+
+//==============================================================================
+void CMProjectAudioProcessor::GrainPool::allocate(int newCapacity)
+{
+    const auto slots = (size_t) juce::jmax(0, newCapacity);
+
+    samplePos.assign(slots, 0.0);
+    sampleStep.assign(slots, 0.0);
+    remainingSamples.assign(slots, 0);
+    totalSamples.assign(slots, 0);
+    gain.assign(slots, 0.0f);
+    windowOffset.assign(slots, 0);
+    windowPhase.assign(slots, 0);
+    windowPhaseInc.assign(slots, 0);
+    sourceOffset.assign(slots, 0);
+    sourceLength.assign(slots, 0);
+    voice.assign(slots, 0);
+
+    for (auto& state : lowpassState)
+        state.assign(slots, 0.0f);
+
+    numActive = 0;
+}
+
+bool CMProjectAudioProcessor::GrainPool::spawn(const Grain& grain) noexcept
+{
+    if (isFull())
+        return false;
+
+    const auto slot = (size_t) numActive++;
+    samplePos[slot] = grain.samplePos;
+    sampleStep[slot] = grain.sampleStep;
+    remainingSamples[slot] = grain.remainingSamples;
+    totalSamples[slot] = grain.totalSamples;
+    gain[slot] = grain.gain;
+    windowOffset[slot] = grain.windowOffset;
+    windowPhaseInc[slot] = GrainWindowBank::getPhaseIncrement(grain.totalSamples);
+    windowPhase[slot] = windowPhaseInc[slot] * (juce::uint32)(grain.totalSamples - grain.remainingSamples);
+    sourceOffset[slot] = grain.sourceOffset;
+    sourceLength[slot] = grain.sourceLength;
+    voice[slot] = grain.voice;
+
+    for (auto& state : lowpassState)
+        state[slot] = 0.0f;
+
+    return true;
+}
+
+void CMProjectAudioProcessor::GrainPool::swapRemove(int index) noexcept
+{
+    jassert(juce::isPositiveAndBelow(index, numActive));
+
+    const auto slot = (size_t) index;
+    const auto last = (size_t) --numActive;
+
+    if (slot == last)
+        return;
+
+    samplePos[slot] = samplePos[last];
+    sampleStep[slot] = sampleStep[last];
+    remainingSamples[slot] = remainingSamples[last];
+    totalSamples[slot] = totalSamples[last];
+    gain[slot] = gain[last];
+    windowOffset[slot] = windowOffset[last];
+    windowPhase[slot] = windowPhase[last];
+    windowPhaseInc[slot] = windowPhaseInc[last];
+    sourceOffset[slot] = sourceOffset[last];
+    sourceLength[slot] = sourceLength[last];
+    voice[slot] = voice[last];
+
+    for (auto& state : lowpassState)
+        state[slot] = state[last];
+}
+
+//==============================================================================
+void CMProjectAudioProcessor::ReleasePool::add(juce::ReferenceCountedObject* object)
+{
+    const juce::ScopedLock sl(lock);
+    entries.push_back({ object });
+}
+
+int CMProjectAudioProcessor::ReleasePool::useTimeSlice()
+{
+    std::vector<Entry> expired; // destroyed on return, outside the lock
+    const auto now = juce::Time::getMillisecondCounter();
+
+    {
+        const juce::ScopedLock sl(lock);
+
+        for (auto it = entries.begin(); it != entries.end();)
+        {
+            if (it->object->getReferenceCount() > 1)
+            {
+                it->isUnused = false;
+                ++it;
+            }
+            else if (! it->isUnused)
+            {
+                it->isUnused = true;
+                it->unusedSince = now;
+                ++it;
+            }
+            else if (now - it->unusedSince >= gracePeriodMs)
+            {
+                expired.push_back(std::move(*it));
+                it = entries.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    return 250;
+}
+
+//==============================================================================
+void CMProjectAudioProcessor::VoiceFilter::reset() noexcept
+{
+    ic1eq.fill(0.0f);
+    ic2eq.fill(0.0f);
+}
+
+bool CMProjectAudioProcessor::VoiceFilter::isSilent() const noexcept
+{
+    constexpr float threshold = 1.0e-5f;
+
+    for (size_t ch = 0; ch < ic1eq.size(); ++ch)
+        if (std::abs(ic1eq[ch]) > threshold || std::abs(ic2eq[ch]) > threshold)
+            return false;
+
+    return true;
+}
+
+CMProjectAudioProcessor::VoiceFilter::Coefficients CMProjectAudioProcessor::VoiceFilter::makeLowpass(float cutoffHz, double sampleRate) noexcept
+{
+    constexpr double k = juce::MathConstants<double>::sqrt2; // 1 / Q for a Butterworth response
+    const double fs = juce::jmax(1.0, sampleRate);
+    const double g = std::tan(juce::MathConstants<double>::pi * juce::jlimit(10.0, 0.49 * fs, (double)cutoffHz) / fs);
+
+    Coefficients c;
+    c.a1 = (float)(1.0 / (1.0 + g * (g + k)));
+    c.a2 = (float)g * c.a1;
+    c.a3 = (float)g * c.a2;
+    return c;
+}
+
+//==============================================================================
+// Table layout: Hann, then numTaperSteps Tukey tables, Gaussian, numTaperSteps trapezoid
+// tables and the exponential decay.
+void CMProjectAudioProcessor::GrainWindowBank::build()
+{
+    const int numTables = 3 + 2 * numTaperSteps;
+    tables.assign((size_t)(numTables * tableStride), 0.0f);
+
+    auto fill = [this](int tableIndex, auto&& shape)
+    {
+        auto* table = tables.data() + tableIndex * tableStride;
+
+        for (int i = 0; i < tableSize; ++i)
+            table[i] = (float)shape((double)i / (double)tableSize);
+
+        table[tableSize] = table[0]; // every shape returns to zero, so the guard wraps to the start
+    };
+
+    const double twoPi = juce::MathConstants<double>::twoPi;
+
+    auto hann = [twoPi](double x) { return 0.5 - 0.5 * std::cos(twoPi * x); };
+
+    auto taperFor = [](int step) { return (double)(step + 1) / (double)numTaperSteps; };
+
+    int tableIndex = 0;
+    fill(tableIndex++, hann);
+
+    for (int step = 0; step < numTaperSteps; ++step)
+    {
+        // Cosine ramps over taper / 2 at either end with a flat top in between.
+        const double ramp = taperFor(step) * 0.5;
+        fill(tableIndex++, [ramp, hann](double x)
+        {
+            if (x < ramp)        return hann(x / (2.0 * ramp));
+            if (x > 1.0 - ramp)  return hann((1.0 - x) / (2.0 * ramp));
+            return 1.0;
+        });
+    }
+
+    // Gaussian (sigma = 0.4), shifted and rescaled so it starts and ends at exactly zero.
+    {
+        const double sigma = 0.4;
+        auto gauss = [sigma](double x) { const double t = (x - 0.5) / (0.5 * sigma); return std::exp(-0.5 * t * t); };
+        const double edge = gauss(0.0);
+        fill(tableIndex++, [gauss, edge](double x) { return (gauss(x) - edge) / (1.0 - edge); });
+    }
+
+    for (int step = 0; step < numTaperSteps; ++step)
+    {
+        const double ramp = taperFor(step) * 0.5;
+        fill(tableIndex++, [ramp](double x) { return juce::jmin(1.0, x / ramp, (1.0 - x) / ramp); });
+    }
+
+    // Percussive shape: 2% attack into an exponential fall of about 60 dB, pinned to zero at the end.
+    {
+        const double attack = 0.02;
+        const double floorLevel = std::exp(-6.9);
+        fill(tableIndex++, [attack, floorLevel](double x)
+        {
+            if (x < attack)
+                return x / attack;
+
+            const double decay = std::exp(-6.9 * (x - attack) / (1.0 - attack));
+            return (decay - floorLevel) / (1.0 - floorLevel);
+        });
+    }
+}
+
+int CMProjectAudioProcessor::GrainWindowBank::getOffset(int shape, float taper) const noexcept
+{
+    const int taperStep = juce::jlimit(0, numTaperSteps - 1, (int)std::ceil(taper * (float)numTaperSteps) - 1);
+
+    switch (shape)
+    {
+        case tukeyWindow:            return (1 + taperStep) * tableStride;
+        case gaussianWindow:         return (1 + numTaperSteps) * tableStride;
+        case trapezoidWindow:        return (2 + numTaperSteps + taperStep) * tableStride;
+        case exponentialDecayWindow: return (2 + 2 * numTaperSteps) * tableStride;
+        case hannWindow:
+        default:                     return 0;
+    }
+}
+
+// Rounded down so the phase of the grain's last sample never wraps past the end of the table.
+juce::uint32 CMProjectAudioProcessor::GrainWindowBank::getPhaseIncrement(int totalSamples) noexcept
+{
+    return (juce::uint32)(((juce::uint64)1 << 32) / (juce::uint64)juce::jmax(2, totalSamples));
+}
+
+//==============================================================================
+// Zeroth-order modified Bessel function of the first kind, for the Kaiser window.
+static double besselI0(double x) noexcept
+{
+    double sum = 1.0, term = 1.0;
+    const double halfX = 0.5 * x;
+
+    for (int k = 1; k < 32; ++k)
+    {
+        term *= (halfX / (double)k) * (halfX / (double)k);
+        sum += term;
+
+        if (term < sum * 1.0e-12)
+            break;
+    }
+
+    return sum;
+}
+
+int CMProjectAudioProcessor::PolyphaseSincTable::getBand(double sampleStep) noexcept
+{
+    // Upper step of each band, 2^(b/2)
+    static constexpr double bandSteps[numBands - 1] { 1.0, 1.4142135623730951, 2.0, 2.8284271247461903 };
+    const double step = std::abs(sampleStep);
+    int band = 0;
+
+    while (band < numBands - 1 && step > bandSteps[band])
+        ++band;
+
+    return band;
+}
+
+void CMProjectAudioProcessor::PolyphaseSincTable::build()
+{
+    constexpr double passband = 0.9; // passband edge as a fraction of Nyquist at unity step
+    constexpr double beta = 8.0;
+    constexpr int leftTaps = numTaps / 2 - 1;
+    const double halfWidth = (double)numTaps * 0.5;
+    const double windowNorm = besselI0(beta);
+
+    coefficients.assign((size_t)(numBands * bandStride), 0.0f);
+
+    // One extra phase at frac = 1 so the last phase also has a delta to interpolate towards.
+    std::vector<double> phases((size_t)((numPhases + 1) * numTaps));
+
+    for (int band = 0; band < numBands; ++band)
+    {
+        const double cutoff = passband / std::pow(2.0, (double)band * 0.5);
+
+        for (int phase = 0; phase <= numPhases; ++phase)
+        {
+            const double frac = (double)phase / (double)numPhases;
+            double* taps = phases.data() + phase * numTaps;
+            double sum = 0.0;
+
+            for (int k = 0; k < numTaps; ++k)
+            {
+                const double t = (double)(k - leftTaps) - frac;
+                const double x = t / halfWidth;
+                const double window = std::abs(x) < 1.0 ? besselI0(beta * std::sqrt(1.0 - x * x)) / windowNorm : 0.0;
+                const double arg = juce::MathConstants<double>::pi * cutoff * t;
+                const double sinc = std::abs(arg) < 1.0e-9 ? 1.0 : std::sin(arg) / arg;
+
+                taps[k] = cutoff * sinc * window;
+                sum += taps[k];
+            }
+
+            for (int k = 0; k < numTaps; ++k)
+                taps[k] /= sum; // unity gain at DC for every phase
+        }
+
+        for (int phase = 0; phase < numPhases; ++phase)
+        {
+            const double* taps = phases.data() + phase * numTaps;
+            const double* next = taps + numTaps;
+            float* out = coefficients.data() + band * bandStride + phase * phaseStride;
+
+            for (int k = 0; k < numTaps; ++k)
+            {
+                out[k] = (float)taps[k];
+                out[numTaps + k] = (float)(next[k] - taps[k]);
+            }
+        }
+    }
+}
+
+//==============================================================================
+void CMProjectAudioProcessor::SynthSamplePyramid::build(const juce::AudioBuffer<float>& source)
+{
+    const int numChannels = source.getNumChannels();
+    numLevels = 0;
+    int totalLength = 0;
+
+    for (int length = source.getNumSamples(); length > 0 && numLevels < maxLevels; length = (length + 1) / 2)
+    {
+        if (numLevels > 0 && length < minLevelLength)
+            break;
+
+        levelOffset[(size_t)numLevels] = totalLength;
+        levelLength[(size_t)numLevels] = length;
+        totalLength += length;
+        ++numLevels;
+    }
+
+    samples.setSize(numChannels, totalLength, false, false, true);
+
+    if (numLevels == 0)
+        return;
+
+    // Half-band Kaiser-windowed sinc: every even tap apart from the centre is zero, so only
+    // the odd taps are stored, as symmetric pairs around the centre.
+    constexpr int numPairs = (halfBandTaps - 1) / 4 + 1;
+    constexpr double beta = 8.0;
+    const double halfWidth = (double)(halfBandTaps / 2 + 1);
+    const double windowNorm = besselI0(beta);
+    std::array<double, numPairs> taps {};
+    double sum = 0.5;
+
+    for (int pair = 0; pair < numPairs; ++pair)
+    {
+        const double k = (double)(2 * pair + 1);
+        const double x = k / halfWidth;
+        const double window = besselI0(beta * std::sqrt(1.0 - x * x)) / windowNorm;
+        taps[(size_t)pair] = std::sin(juce::MathConstants<double>::halfPi * k) / (juce::MathConstants<double>::pi * k) * window;
+        sum += 2.0 * taps[(size_t)pair];
+    }
+
+    for (auto& tap : taps)
+        tap /= sum;
+
+    const double centreTap = 0.5 / sum;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        float* data = samples.getWritePointer(ch);
+        std::copy_n(source.getReadPointer(ch), levelLength[0], data);
+
+        for (int level = 1; level < numLevels; ++level)
+        {
+            const float* in = data + levelOffset[(size_t)(level - 1)];
+            const int inLength = levelLength[(size_t)(level - 1)];
+            float* out = data + levelOffset[(size_t)level];
+
+            // Output n sits on input 2n, so every level stays time-aligned with the original.
+            for (int n = 0; n < levelLength[(size_t)level]; ++n)
+            {
+                const int centre = 2 * n;
+                double acc = centreTap * in[centre];
+
+                for (int pair = 0; pair < numPairs; ++pair)
+                {
+                    const int k = 2 * pair + 1;
+                    const float before = in[juce::jmax(0, centre - k)];
+                    const float after = in[juce::jmin(inLength - 1, centre + k)];
+                    acc += taps[(size_t)pair] * (double)(before + after);
+                }
+
+                out[n] = (float)acc;
+            }
+        }
+    }
+}
+
+int CMProjectAudioProcessor::SynthSamplePyramid::getLevelForStep(double sampleStep) const noexcept
+{
+    const double absStep = std::abs(sampleStep);
+
+    if (numLevels <= 1 || absStep <= 1.0)
+        return 0;
+
+    return juce::jlimit(0, numLevels - 1, (int)std::ceil(std::log2(absStep) - 1.0e-9));
+}
+
+size_t CMProjectAudioProcessor::SynthSamplePyramid::getMemoryBytes() const noexcept
+{
+    return (size_t)samples.getNumChannels() * (size_t)samples.getNumSamples() * sizeof(float);
+}
+
+//==============================================================================
+void CMProjectAudioProcessor::SampleRateConverter::build()
+{
+    constexpr double beta = 9.0;
+    const double windowNorm = besselI0(beta);
+    const int numPoints = zeroCrossings * kernelResolution;
+
+    // Two zeros past the end so the lookup can always interpolate towards the next point.
+    kernel.assign((size_t)numPoints + 2, 0.0f);
+
+    for (int i = 0; i <= numPoints; ++i)
+    {
+        const double u = (double)i / (double)kernelResolution;
+        const double x = u / (double)zeroCrossings;
+        const double arg = juce::MathConstants<double>::pi * u;
+        const double sinc = i == 0 ? 1.0 : std::sin(arg) / arg;
+
+        kernel[(size_t)i] = (float)(sinc * besselI0(beta * std::sqrt(juce::jmax(0.0, 1.0 - x * x))) / windowNorm);
+    }
+}
+
+bool CMProjectAudioProcessor::SampleRateConverter::convert(const DecodedAudio& source, double targetRate,
+                                                           juce::AudioBuffer<float>& dest, juce::ThreadPool& pool,
+                                                           const std::function<bool()>& isCancelled,
+                                                           const std::function<void(float)>& onProgress) const
+{
+    const auto& in = source.buffer;
+
+    if (source.sampleRate <= 0.0 || targetRate <= 0.0 || source.sampleRate == targetRate || in.getNumSamples() == 0)
+    {
+        dest.makeCopyOf(in);
+        return ! isCancelled();
+    }
+
+    const double step = source.sampleRate / targetRate;
+    const double cutoff = 0.9 * juce::jmin(1.0, 1.0 / step); // fraction of the input Nyquist
+    const int inLength = in.getNumSamples();
+    const int outLength = (int)std::ceil((double)inLength / step);
+    dest.setSize(in.getNumChannels(), outLength, false, false, true);
+
+    // Blocks are claimed from a shared counter, by this job and by helpers on the pool. The
+    // caller works through the blocks as well, so it finishes even if no helper ever gets a
+    // thread, and it waits for the blocks the helpers did claim before returning. Helpers that
+    // start late find nothing left and only touch the shared state.
+    struct Work
+    {
+        std::atomic<int> nextBlock { 0 };
+        std::atomic<int> blocksDone { 0 };
+        int numBlocks = 0;
+        juce::WaitableEvent finished;
+        std::function<void(int)> convertOne;
+    };
+
+    const int blocksPerChannel = (outLength + blockLength - 1) / blockLength;
+    auto work = std::make_shared<Work>();
+    work->numBlocks = blocksPerChannel * in.getNumChannels();
+    work->convertOne = [&] (int block)
+    {
+        if (isCancelled())
+            return;
+
+        const int channel = block / blocksPerChannel;
+        const int outStart = (block % blocksPerChannel) * blockLength;
+        convertBlock(in.getReadPointer(channel), inLength, dest.getWritePointer(channel),
+                     outStart, juce::jmin(outLength, outStart + blockLength), step, cutoff);
+
+        // Blocks are claimed in order, so this is close enough without another counter.
+        onProgress((float)(block + 1) / (float)work->numBlocks);
+    };
+
+    const auto runBlocks = [work]
+    {
+        for (int block = work->nextBlock++; block < work->numBlocks; block = work->nextBlock++)
+        {
+            work->convertOne(block);
+
+            if (++work->blocksDone == work->numBlocks)
+                work->finished.signal();
+        }
+    };
+
+    const int numHelpers = juce::jmin(pool.getNumThreads() - 1, work->numBlocks - 1);
+    for (int i = 0; i < numHelpers; ++i)
+        pool.addJob(runBlocks);
+
+    runBlocks();
+    work->finished.wait();
+    return ! isCancelled();
+}
+
+// Output sample n sits at n * step in the input. Samples beyond either end of the input count
+// as silence, which suits one-shots and lets each block be converted on its own.
+void CMProjectAudioProcessor::SampleRateConverter::convertBlock(const float* in, int inLength, float* out,
+                                                                int outStart, int outEnd, double step,
+                                                                double cutoff) const noexcept
+{
+    const double halfWidth = (double)zeroCrossings / cutoff;
+    const double tableScale = cutoff * (double)kernelResolution;
+    const int lastPoint = (int)kernel.size() - 2;
+
+    for (int n = outStart; n < outEnd; ++n)
+    {
+        const double centre = (double)n * step;
+        const int first = juce::jmax(0, (int)std::ceil(centre - halfWidth));
+        const int last = juce::jmin(inLength - 1, (int)std::floor(centre + halfWidth));
+        double acc = 0.0;
+
+        for (int k = first; k <= last; ++k)
+        {
+            const double position = std::abs(centre - (double)k) * tableScale;
+            const int point = juce::jmin(lastPoint, (int)position);
+            const double frac = position - (double)point;
+            const double tap = kernel[(size_t)point] + frac * (double)(kernel[(size_t)point + 1] - kernel[(size_t)point]);
+            acc += tap * (double)in[k];
+        }
+
+        out[n] = (float)(acc * cutoff);
+    }
 }
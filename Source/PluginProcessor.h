@@ -9,10 +9,13 @@
 #pragma once
 #include <JuceHeader.h>
 #include <array>
+#include <functional>
+#include <limits>
+#include <memory>
 #include <vector>
 
 class CMProjectAudioProcessor  : public juce::AudioProcessor,
-                                 public juce::OSCReceiver::ListenerWithOSCAddress<juce::OSCReceiver::MessageLoopCallback>
+                                 public juce::OSCReceiver::ListenerWithOSCAddress<juce::OSCReceiver::RealtimeCallback>
 {
 public:
     //==============================================================================
@@ -69,6 +72,13 @@ public:
     
     void sendFingerAssignementsOSC();
     void sendFingerDrumMappingOSC();
+    void sendActivePageOSC(const juce::String& page);
+
+    // Creates the shared-memory region for a tracker about to be launched and returns the name
+    // to pass it with --shm, or an empty string when shared memory is unavailable (Windows, or
+    // shm_open failed) and everything stays on UDP.
+    juce::String openSharedGestureTransport();
+    void closeSharedGestureTransport();
 
     //Getter methods for GUI update
     float getGrainDur() const { return grainDur.load(); }
@@ -77,6 +87,8 @@ public:
     float getDensity() const { return density.load(); }
     float getPitch() const { return pitch.load(); }
     float getReverse() const { return reverse.load(); }
+    int getWindowShape() const { return windowShape.load(); }
+    float getWindowTaper() const { return windowTaper.load(); }
     
     void setGrainDur(float x)  { grainDur.store(x); }
     void setGrainPos(float x) { grainPos.store(x); }
@@ -84,20 +96,153 @@ public:
     void setDensity(float x)  { density.store(x);}
     void setPitch(float x) { pitch.store(x); }
     void setReverse(float x)  { reverse.store(x);}
+    void setWindowShape(int x) { windowShape.store(juce::jlimit(0, numGrainWindowShapes - 1, x)); }
+    void setWindowTaper(float x) { windowTaper.store(juce::jlimit(0.0f, 1.0f, x)); }
+
+    // Grain envelope shapes, selected with setWindowShape. The taper sets the ramp length
+    // of the Tukey and trapezoid shapes as a fraction of the grain. Both are on the editor's
+    // Engine panel and OSC (/windowShape shape, /windowTaper amount), and saved with the state.
+    enum GrainWindowShape
+    {
+        hannWindow = 0,
+        tukeyWindow,
+        gaussianWindow,
+        trapezoidWindow,
+        exponentialDecayWindow,
+        numGrainWindowShapes
+    };
+
+    // Grain read interpolation, cheapest first. Live playback and offline renders (bounces)
+    // each have their own setting so performing can stay on a draft tier. Both are on the
+    // Engine panel and OSC (/interpolationMode mode offline), and saved with the state.
+    enum InterpolationMode
+    {
+        linearInterpolation = 0,
+        hermiteInterpolation,
+        sincInterpolation,
+        numInterpolationModes
+    };
+
+    // Where the cutoff is applied: one state-variable filter on the summed grains (the
+    // default), or a one-pole on every grain as the original engine did. On the Engine panel
+    // and OSC (/grainFilterMode mode), and saved with the state.
+    enum GrainFilterMode
+    {
+        voiceFilter = 0,
+        perGrainFilter,
+        numGrainFilterModes
+    };
+
+    int getGrainFilterMode() const { return grainFilterMode.load(); }
+    void setGrainFilterMode(int x) { grainFilterMode.store(juce::jlimit(0, numGrainFilterModes - 1, x)); }
+
+    int getInterpolationMode(bool forOfflineRender) const { return (forOfflineRender ? offlineInterpolation : liveInterpolation).load(); }
+    void setInterpolationMode(int mode, bool forOfflineRender) { (forOfflineRender ? offlineInterpolation : liveInterpolation).store(juce::jlimit(0, numInterpolationModes - 1, mode)); }
+    // Measured once on this machine by a background job after construction (0 until it has
+    // run); nanoseconds per grain per output sample.
+    float getInterpolationCostNs(int mode) const { return interpolationCostNs[(size_t)juce::jlimit(0, numInterpolationModes - 1, mode)].load(); }
+    // Memory of the loaded synth sample including its octave pyramid, and that total as a
+    // multiple of the plain decoded sample (always below 2).
+    size_t getSynthSampleMemoryBytes() const { return synthSampleMemoryBytes.load(); }
+    float getSynthSampleMemoryRatio() const { return synthSampleMemoryRatio.load(); }
 
     void updateParameters();
-    void loadSynthSample(const juce::File& file);
+    // Puts the gesture-driven parameters back to where the tracker used to start them.
+    void resetGestureParameters();
+    // A file as decoded, at its own rate. Kept after loading so the engine copy can be
+    // converted again when the host changes the rate, and shared with the editor's waveform.
+    struct DecodedAudio
+    {
+        juce::AudioBuffer<float> buffer;
+        double sampleRate = 0.0;
+    };
+
+    // Loading returns at once: the file is decoded and converted on a background job, and a
+    // newer file for the same destination cancels the one still loading. With reversed set the
+    // job plays the file backwards.
+    void loadSynthSample(const juce::File& file, bool reversed = false);
+    // Between 0 and 1 while a file is loading, -1 otherwise.
+    float getSynthLoadProgress() const { return loadProgress[(size_t)synthConversionSlot].load(); }
+    // The synth file as last decoded, or nullptr; a new pointer means a new file.
+    std::shared_ptr<const DecodedAudio> getDecodedSynthSample() const;
+    // Queue a note for the synth from the message thread; the audio thread picks it up at the
+    // start of the next block. MIDI input goes to the voice allocator directly.
     void startManualSynthNote(int noteNumber, float velocity);
     void stopManualSynthNote(int noteNumber);
+
+    // When every voice is busy, a new note takes a voice that is only ringing out if there
+    // is one, otherwise the oldest or the quietest voice. The steal mode and the grain budget
+    // below are on the Engine panel and OSC (/voiceStealMode mode, /grainBudget grains), and
+    // saved with the state.
+    enum VoiceStealMode
+    {
+        stealOldestVoice = 0,
+        stealQuietestVoice,
+        numVoiceStealModes
+    };
+
+    int getVoiceStealMode() const { return voiceStealMode.load(); }
+    void setVoiceStealMode(int x) { voiceStealMode.store(juce::jlimit(0, numVoiceStealModes - 1, x)); }
+    // Total grains all voices may have sounding at once, split evenly between sounding voices.
+    // A budget above the grain pool prepareToPlay allocated plays as the whole pool, so values
+    // restored before the host prepares survive; the getter reports what actually applies.
+    int getGrainBudget() const
+    {
+        const int capacity = grainPoolCapacity.load();
+        return capacity > 0 ? juce::jmin(grainBudget.load(), capacity) : grainBudget.load();
+    }
+    void setGrainBudget(int x) { grainBudget.store(juce::jmax(1, x)); }
+    // Grains the pool can hold at the current sample rate and block size; 0 before prepareToPlay.
+    int getGrainPoolCapacity() const { return grainPoolCapacity.load(); }
     void setCurrentBpm(float bpm) { currentBpm.store(juce::jmax(1.0f, bpm)); }
+
+    // Drum step sequencer: 16 sixteenth-note steps per track, bit n of a pattern is step n.
+    // Steps fire on the audio thread from the transport clock, with or without the editor open.
+    // Controllers drive it over OSC on port 9001 (/sequencerStep track step on,
+    // /sequencerPattern track bits, /sequencerRunning on) and it is saved with the plugin state.
+    static constexpr int numSequencerSteps = 16;
+    juce::uint16 getSequencerPattern(int trackIndex) const { return sequencerPatterns[(size_t)juce::jlimit(0, 3, trackIndex)].load(); }
+    void setSequencerPattern(int trackIndex, juce::uint16 pattern) { if (juce::isPositiveAndBelow(trackIndex, 4)) sequencerPatterns[(size_t)trackIndex].store(pattern); }
+    bool getSequencerStep(int trackIndex, int step) const { return juce::isPositiveAndBelow(step, numSequencerSteps) && ((getSequencerPattern(trackIndex) >> step) & 1) != 0; }
+    void setSequencerStep(int trackIndex, int step, bool isOn);
+    bool isSequencerRunning() const { return sequencerRunning.load(); }
+    void setSequencerRunning(bool shouldRun) { sequencerRunning.store(shouldRun); }
+    // The step last played, or -1 while the sequencer is stopped; for drawing a playhead.
+    int getSequencerPlayStep() const { return sequencerPlayStep.load(); }
+    // Gestures stamped by the tracker sound this long after the fastest capture-to-receive time
+    // seen, so every hit has the same delay whatever the tracking and network jitter was.
+    float getGestureLatencyMs() const { return gestureLatencyMs.load(); }
+    void setGestureLatencyMs(float ms) { gestureLatencyMs.store(juce::jlimit(0.0f, 200.0f, ms)); }
+    // Landmarks are One-Euro filtered on arrival and extrapolated this far ahead. Below zero
+    // (the default) the horizon follows how late the audio answers the camera: from each frame's
+    // capture to the time its gestures are due, plus one audio block of output buffering. A
+    // longer horizon hides more of that lag but overshoots when a hand turns; capped at 100 ms.
+    // Both settings are on the Engine panel and OSC (/gestureLatency ms,
+    // /landmarkPrediction ms), and saved with the state.
+    float getLandmarkPredictionMs() const { return landmarkPredictionMs.load(); }
+    void setLandmarkPredictionMs(float ms) { landmarkPredictionMs.store(ms < 0.0f ? -1.0f : juce::jmin(maxPredictionMs, ms)); }
+    static constexpr float maxPredictionMs = 100.0f;
+    // Capture-to-receive latency of the tracker's frames, or below zero when it can't be measured
+    float getMeasuredTrackerLatencyMs() const { return measuredTrackerLatencyMs.load(); }
     
     struct TrackedHandState
     {
         bool visible = false;
+        float handedness = 0.0f; // classifier score, from /handFrame only
         std::array<juce::Point<float>, 21> landmarks {};
+        std::array<float, 21> confidence {};
+    };
+
+    struct HandFrame
+    {
+        juce::uint32 sequence = 0; // bumped for every frame received, 0 once cleared
+        std::array<TrackedHandState, 2> hands {};
     };
 
-    std::array<TrackedHandState, 2> getTrackedHands() const;
+    // Message thread only. Never blocks the OSC receiver; the returned frame stays valid until
+    // the next call, and readers can compare its sequence to skip work when nothing changed.
+    const HandFrame& getLatestHandFrame() const;
+    // Call when the tracker stops. Frames that arrive afterwards start a new tracker session.
     void clearTrackedHands();
     
 
@@ -107,6 +252,7 @@ private:
     
    
     juce::OSCReceiver oscReceiver;
+    bool oscReceiverConnected = false; // message thread
     
     bool isRecordingMidi = false;
     juce::MidiMessageSequence recordedSequence;
@@ -119,11 +265,6 @@ private:
     std::atomic<bool> isRecordingAudio { false };
 
     juce::AudioFormatManager formatManager;
-    std::array<juce::AudioBuffer<float>, 4> drumSamples;
-    std::array<bool, 4> sampleLoaded = { false, false, false, false };
-    std::array<int, 4> playbackPositions = { 0, 0, 0, 0 };
-    std::array<bool, 4> triggerPlayback = { false, false, false, false };
-    std::mutex sampleMutex; // optional but safe
 
     // GUI update parameters
     std::atomic<float> grainDur{ 0.06f };
@@ -132,26 +273,230 @@ private:
     std::atomic<float> density{ 0.8f };
     std::atomic<float> pitch{ 0.0f };
     std::atomic<float> reverse{ 0.0f };
+    std::atomic<int> windowShape{ hannWindow };
+    std::atomic<float> windowTaper{ 0.5f };
+    std::atomic<int> grainFilterMode{ voiceFilter };
+    std::atomic<int> voiceStealMode{ stealOldestVoice };
+    std::atomic<int> grainBudget{ std::numeric_limits<int>::max() }; // the whole pool
+    std::atomic<int> grainPoolCapacity{ 0 };
+    std::atomic<int> liveInterpolation{ linearInterpolation };
+    std::atomic<int> offlineInterpolation{ sincInterpolation };
+    std::array<std::atomic<float>, numInterpolationModes> interpolationCostNs {};
+    std::atomic<size_t> synthSampleMemoryBytes{ 0 };
+    std::atomic<float> synthSampleMemoryRatio{ 0.0f };
     std::atomic<float> currentBpm{ 120.0f };
-    mutable juce::CriticalSection trackedHandsLock;
-    std::array<TrackedHandState, 2> trackedHands;
+    // Hands the latest hand frame from the OSC receiver thread to the message thread without
+    // waiting. The writer fills its own slot and swaps it into the middle one; the reader swaps
+    // the middle slot for its own only when the writer has marked it as newer.
+    class HandFrameTripleBuffer
+    {
+    public:
+        HandFrame& getWriteFrame() noexcept { return frames[(size_t)writeIndex]; }
+        void publish() noexcept;
+        const HandFrame& read() noexcept;
+
+    private:
+        static constexpr int newFrameBit = 4;
+        std::array<HandFrame, 3> frames;
+        std::atomic<int> middleIndex { 1 };
+        int writeIndex = 0;
+        int readIndex = 2;
+    };
+
+    static constexpr int handFrameVersion = 1;
+    static constexpr int handFrameBytes = 12 + 2 * (4 + 21 * 6);
+    // Gesture engine, run on every received hand frame while the synth page is showing. Each
+    // finger's thumb distance goes through a power-curve table onto the parameter assigned to
+    // it in fingerControls; a left fist freezes everything.
+    enum FingerParameter
+    {
+        fingerGrainDur = 0,
+        fingerGrainPos,
+        fingerGrainCutOff,
+        fingerGrainDensity,
+        fingerGrainPitch,
+        fingerGrainReverse,
+        numFingerParameters
+    };
+
+    static int getFingerParameterId(const juce::String& name) noexcept;
+
+    struct GestureCurve
+    {
+        static constexpr int tableSize = 256;
+        static constexpr float power = 2.5f;
+
+        void build();
+        float map(float x, float inMin, float inMax, float outMin, float outMax) const noexcept;
+
+        std::array<float, tableSize + 1> table {};
+    };
+
+    // One-Euro filter: a low-pass whose cutoff rises with speed, so the hand is steady when
+    // held still and follows quickly when it moves. The smoothed derivative also drives the
+    // prediction.
+    struct OneEuroFilter
+    {
+        static constexpr float minCutoff = 1.5f;       // Hz
+        static constexpr float beta = 10.0f;           // cutoff increase per unit/s of speed
+        static constexpr float derivativeCutoff = 1.0f;
+
+        float process(float x, float dt) noexcept;
+
+        bool isPrimed = false;
+        float value = 0.0f;
+        float derivative = 0.0f;
+    };
+
+    struct HandFilter
+    {
+        std::array<OneEuroFilter, 42> coordinates; // x and y of each landmark
+        juce::uint32 lastFrameMicros = 0;
+    };
+
+    std::array<HandFilter, 2> handFilters;              // same thread as receivedHands
+    std::array<TrackedHandState, 2> filteredHands;
+    float trackerLatencyMs = -1.0f;
+    std::atomic<float> landmarkPredictionMs { -1.0f };
+    std::atomic<float> measuredTrackerLatencyMs { -1.0f };
+    GestureCurve gestureCurve;
+    std::array<std::atomic<int>, 4> fingerParameterIds { -1, -1, -1, -1 }; // written on the message thread
+    std::atomic<bool> synthPageActive { true };
+    std::atomic<float> synthSampleSeconds { 10.0f };
+    std::array<TrackedHandState, 2> receivedHands;      // OSC receiver thread, or the transport
+    juce::uint32 lastTrackerFrameSequence = 0;          // reader while shared memory is in use
+    bool hasTrackerFrame = false;
+    // Set by clearTrackedHands when the tracker stops; a relaunched tracker counts its frames
+    // from 1 again, so the frame reader starts over instead of dropping them as stale.
+    std::atomic<bool> trackerRestarted { false };
+    std::atomic<juce::uint32> lastHandSequence { 0 };   // written by the hand-state writer
+    // Hand frames come from exactly one source: OSC until the shared memory is opened, then
+    // only its reader. The try-lock backs that up across the switch-over.
+    std::atomic<bool> sharedHandFramesAttached { false };
+    juce::SpinLock handStateWriter;
+    mutable HandFrameTripleBuffer handFrames;
+    juce::uint32 handsClearedThrough = 0;               // message thread
+    HandFrame clearedHandFrame;
     
 
 public:
     void loadSampleForTrack(int trackIndex, const juce::File& file);
+    float getTrackLoadProgress(int trackIndex) const { return loadProgress[(size_t)juce::jlimit(0, 3, trackIndex)].load(); }
     void triggerSamplePlayback(int trackIndex);
+    // Tracks sharing a choke group above 0 cut each other off, like closed and open hats.
+    // Set from the editor's Engine panel or over OSC (/drumChokeGroup track group), and saved
+    // with the plugin state.
+    static constexpr int numDrumChokeGroups = 4;
+    int getDrumChokeGroup(int trackIndex) const { return drumChokeGroups[(size_t)juce::jlimit(0, 3, trackIndex)].load(); }
+    void setDrumChokeGroup(int trackIndex, int group) { if (juce::isPositiveAndBelow(trackIndex, 4)) drumChokeGroups[(size_t)trackIndex].store(juce::jlimit(0, numDrumChokeGroups, group)); }
+    // Linear gain; the audio thread ramps towards a new value over 20 ms. On the Engine panel
+    // and OSC (/drumVolume track gain), and saved with the state.
+    float getTrackVolume(int trackIndex) const { return trackVolumes[(size_t)juce::jlimit(0, 3, trackIndex)].load(); }
+    void setTrackVolume(int trackIndex, float gain) { if (juce::isPositiveAndBelow(trackIndex, 4)) trackVolumes[(size_t)trackIndex].store(juce::jmax(0.0f, gain)); }
+    // Runs on the OSC receiver thread, so gestures never wait behind editor repaints. It only
+    // writes atomics and the lock-free queues it is the single producer of.
     void oscMessageReceived(const juce::OSCMessage& message) override;
-    std::array<float, 4> trackVolumes = { 1.0f, 1.0f, 1.0f, 1.0f };
-    juce::AudioBuffer<float> synthSample;
-    bool synthSampleLoaded = false;
-    std::mutex synthSampleMutex;
     double currentSampleRate = 44100.0;
-    double samplesUntilNextGrain = 0.0;
-    int heldSynthNotes = 0;
-    float synthVelocity = 1.0f;
-    float currentPitchRatio = 1.0f;
     float pitchWheelSemitones = 0.0f;
 
+    // isBusesLayoutSupported only accepts mono or stereo output, so two render channels cover
+    // every layout the host can give us.
+    static constexpr int maxRenderChannels = 2;
+    static constexpr int maxSynthVoices = 8;
+    // Grain triggers per voice are capped at maxGrainRateHz (the gesture mapping reaches about
+    // that at 300 BPM and full density) and grains last at most maxGrainSeconds, which bounds
+    // how many can overlap; prepareToPlay sizes the grain pool from the two.
+    static constexpr double maxGrainRateHz = 100.0;
+    static constexpr double maxGrainSeconds = 0.5;
+
+    // Keeps a reference to every object handed to the audio thread and deletes it on its own
+    // thread once nothing else has held it for a while. The audio thread can then drop its
+    // references freely without ever being the one that frees memory. The grace period covers
+    // an audio thread that has loaded a raw pointer but not yet taken its reference.
+    class ReleasePool : public juce::TimeSliceClient
+    {
+    public:
+        void add(juce::ReferenceCountedObject* object);
+        int useTimeSlice() override;
+
+    private:
+        struct Entry
+        {
+            juce::ReferenceCountedObjectPtr<juce::ReferenceCountedObject> object;
+            bool isUnused = false;
+            juce::uint32 unusedSince = 0;
+        };
+
+        static constexpr juce::uint32 gracePeriodMs = 1000;
+        juce::CriticalSection lock;
+        std::vector<Entry> entries;
+    };
+
+    // Optional shared-memory link to the tracker on x86 macOS and Linux. The tracker writes hand
+    // frames (the /handFrame blob) into a ring, which a reader thread polls, and reads the
+    // finger and page settings from a mailbox the plugin writes; neither goes through a socket.
+    // Drum triggers stay on OSC. Grain parameters come from the frames through the gesture
+    // engine, timed from each frame's capture stamp like the triggers.
+    class SharedGestureTransport : public juce::TimeSliceClient
+    {
+    public:
+        explicit SharedGestureTransport(CMProjectAudioProcessor& owner) : processor(owner) {}
+        ~SharedGestureTransport() override { close(); }
+
+        bool open();
+        void close();
+        bool isOpen() const noexcept { return region != nullptr; }
+        bool isTrackerAttached() const noexcept;
+        const juce::String& getName() const noexcept { return name; }
+
+        void writeControls(const juce::String (&fingerParameters)[4], const juce::String (&fingerDrums)[4],
+                           const juce::String& activePage);
+        int useTimeSlice() override;
+
+    private:
+        struct Region;
+
+        CMProjectAudioProcessor& processor;
+        Region* region = nullptr;
+        juce::String name;
+        juce::uint32 framesRead = 0;
+    };
+
+    // Single-producer single-consumer queue over a preallocated array, for handing small
+    // events from one thread to the audio thread without locks.
+    template <typename Item, int capacity>
+    struct LockFreeQueue
+    {
+        bool push(const Item& item) noexcept
+        {
+            int start1, size1, start2, size2;
+            fifo.prepareToWrite(1, start1, size1, start2, size2);
+
+            if (size1 + size2 < 1)
+                return false;
+
+            items[(size_t)(size1 > 0 ? start1 : start2)] = item;
+            fifo.finishedWrite(1);
+            return true;
+        }
+
+        bool pop(Item& item) noexcept
+        {
+            int start1, size1, start2, size2;
+            fifo.prepareToRead(1, start1, size1, start2, size2);
+
+            if (size1 + size2 < 1)
+                return false;
+
+            item = items[(size_t)(size1 > 0 ? start1 : start2)];
+            fifo.finishedRead(1);
+            return true;
+        }
+
+        juce::AbstractFifo fifo { capacity };
+        std::array<Item, (size_t)capacity> items {};
+    };
+
     struct Grain
     {
         double samplePos = 0.0;
@@ -159,12 +504,430 @@ public:
         int remainingSamples = 0;
         int totalSamples = 0;
         float gain = 0.0f;
-        float lowpassState = 0.0f;
+        int windowOffset = 0; // start of this grain's table inside GrainWindowBank
+        int sourceOffset = 0; // start of the pyramid level this grain reads
+        int sourceLength = 0; // length of that level
+        int voice = 0;
+    };
+
+    // The loaded synth sample plus copies decimated by 2, 4, 8 ... each behind a half-band
+    // lowpass, one level per octave. A grain transposed up by n octaves reads level n at
+    // 1/2^n of its rate, so it never steps over more than one sample per output sample and
+    // linear interpolation stays alias-free. All levels live back to back in one buffer per
+    // channel; the extra levels add less than one copy of the original.
+    struct SynthSamplePyramid
+    {
+        static constexpr int maxLevels = 8;
+        static constexpr int minLevelLength = 64;
+        static constexpr int halfBandTaps = 47;
+
+        void build(const juce::AudioBuffer<float>& source);
+
+        int getNumLevels() const noexcept { return numLevels; }
+        int getNumChannels() const noexcept { return samples.getNumChannels(); }
+        int getLevelOffset(int level) const noexcept { return levelOffset[(size_t)level]; }
+        int getLevelLength(int level) const noexcept { return numLevels > 0 ? levelLength[(size_t)level] : 0; }
+        int getLevelForStep(double sampleStep) const noexcept;
+        size_t getMemoryBytes() const noexcept;
+        const float* const* getArrayOfReadPointers() const noexcept { return samples.getArrayOfReadPointers(); }
+
+        juce::AudioBuffer<float> samples;
+        std::array<int, maxLevels> levelOffset {};
+        std::array<int, maxLevels> levelLength {};
+        int numLevels = 0;
+    };
+
+    // Precomputed grain envelopes, stored back to back in one array so grains (and SIMD
+    // lanes) address any shape with a plain offset. Each table holds tableSize points plus
+    // a guard point for interpolation and is read through a 32-bit fixed-point phase whose
+    // top tableBits bits are the index.
+    struct GrainWindowBank
+    {
+        static constexpr int tableBits = 11;
+        static constexpr int tableSize = 1 << tableBits;
+        static constexpr int tableStride = tableSize + 1;
+        static constexpr int fracBits = 32 - tableBits;
+        static constexpr int numTaperSteps = 8;
+
+        void build();
+        int getOffset(int shape, float taper) const noexcept;
+        const float* data() const noexcept { return tables.data(); }
+
+        static juce::uint32 getPhaseIncrement(int totalSamples) noexcept;
+
+        std::vector<float> tables;
+    };
+
+    // Fixed-capacity grain storage laid out as a structure of arrays. Live grains occupy
+    // [0, numActive) and the tail is the free list, so spawning takes the first free slot
+    // and retiring a grain swaps the last live grain into its place. Sized in prepareToPlay,
+    // never resized on the audio thread.
+    struct GrainPool
+    {
+        void allocate(int newCapacity);
+        void clear() noexcept { numActive = 0; }
+        bool spawn(const Grain& grain) noexcept;
+        void swapRemove(int index) noexcept;
+
+        int size() const noexcept { return numActive; }
+        int capacity() const noexcept { return (int) samplePos.size(); }
+        bool isEmpty() const noexcept { return numActive == 0; }
+        bool isFull() const noexcept { return numActive >= capacity(); }
+
+        std::vector<double> samplePos;
+        std::vector<double> sampleStep;
+        std::vector<int> remainingSamples;
+        std::vector<int> totalSamples;
+        std::vector<float> gain;
+        std::array<std::vector<float>, maxRenderChannels> lowpassState; // per-grain filter state, one per render channel
+        std::vector<int> windowOffset;
+        std::vector<juce::uint32> windowPhase;
+        std::vector<juce::uint32> windowPhaseInc;
+        std::vector<int> sourceOffset;
+        std::vector<int> sourceLength;
+        std::vector<int> voice;
+        int numActive = 0;
+    };
+
+    // Kaiser-windowed sinc for the top interpolation tier: numTaps taps around the read
+    // position at numPhases fractional offsets. Each phase stores its coefficients followed
+    // by the delta to the next phase, so fractions between phases are interpolated.
+    // There is one table per bandwidth band: band b serves read steps up to 2^(b/2) and
+    // scales the cutoff down by that step, so transposing up stays below the source Nyquist.
+    struct PolyphaseSincTable
+    {
+        static constexpr int numTaps = 16;
+        static constexpr int numPhases = 256;
+        static constexpr int phaseStride = numTaps * 2;
+        static constexpr int numBands = 5;
+        static constexpr int bandStride = numPhases * phaseStride;
+
+        void build();
+        const float* data() const noexcept { return coefficients.data(); }
+        // Start of the table to use for a grain reading at sampleStep source samples per output.
+        const float* data(double sampleStep) const noexcept { return coefficients.data() + getBand(sampleStep) * bandStride; }
+        static int getBand(double sampleStep) noexcept;
+
+        std::vector<float> coefficients;
+    };
+
+    // Everything a grain needs to render one span, resolved once per block. The source is
+    // the whole pyramid; each grain adds its own level offset and length. Outputs hold
+    // maxRenderChannels pointers per voice, into that voice's mix.
+    struct GrainRenderContext
+    {
+        const float* const* source = nullptr;
+        int sourceChannels = 0;
+        float* const* outputs = nullptr;
+        int numOutputs = 0;
+        float lowpassAlpha = 1.0f; // per-grain one-pole coefficient; 1 bypasses it
+        const float* windows = nullptr;
+        const float* sincTable = nullptr;
+        int interpolation = linearInterpolation;
+    };
+
+    // A decoded synth sample with its pyramid. Built off the audio thread, never modified
+    // after it is published, and swapped in by pointer.
+    struct SynthSample : public juce::ReferenceCountedObject
+    {
+        using Ptr = juce::ReferenceCountedObjectPtr<SynthSample>;
+
+        SynthSamplePyramid pyramid;
+    };
+
+    // One decoded drum one-shot, published per track the same way as SynthSample.
+    struct DrumSample : public juce::ReferenceCountedObject
+    {
+        using Ptr = juce::ReferenceCountedObjectPtr<DrumSample>;
+
+        juce::AudioBuffer<float> buffer;
+    };
+
+    // Converts decoded audio to the engine rate with a Kaiser-windowed sinc whose cutoff sits
+    // below the lower of the two Nyquist frequencies, so downsampling is band-limited as well.
+    // The kernel is tabulated once. The output is cut into blocks that do not depend on each
+    // other, and the blocks of a long file are shared out across a thread pool.
+    class SampleRateConverter
+    {
+    public:
+        static constexpr int zeroCrossings = 32;     // each side of the centre, at the cutoff
+        static constexpr int kernelResolution = 512; // table points per zero crossing
+        static constexpr int blockLength = 1 << 16;  // output samples per unit of work
+
+        void build();
+        // Runs on a pool thread and uses the rest of the pool as helpers. onProgress gets the
+        // fraction of blocks done. Returns false if isCancelled turned true before every block
+        // was converted.
+        bool convert(const DecodedAudio& source, double targetRate, juce::AudioBuffer<float>& dest,
+                     juce::ThreadPool& pool, const std::function<bool()>& isCancelled,
+                     const std::function<void(float)>& onProgress) const;
+
+    private:
+        void convertBlock(const float* in, int inLength, float* out, int outStart, int outEnd,
+                          double step, double cutoff) const noexcept;
+
+        std::vector<float> kernel;
+    };
+
+    // One sounding drum hit. Hits overlap, up to maxVoicesPerDrumTrack per track. A voice that
+    // is stolen or choked fades out over a couple of milliseconds instead of being cut. The voice
+    // holds its own reference to the sample, so a hit keeps ringing when the track is reloaded.
+    struct DrumVoice
+    {
+        bool isActive() const noexcept { return sample != nullptr; }
+
+        DrumSample::Ptr sample;
+        int track = 0;
+        int position = 0;
+        juce::uint32 startOrder = 0;
+        int fadeRemaining = 0; // > 0 while fading out
+    };
+
+    // Topology-preserving transform (trapezoidal) state-variable lowpass, 12 dB/oct with a
+    // Butterworth Q, holding one integrator pair per channel. Coefficients can be updated
+    // every sample without the zipper noise or blow-ups of a direct-form biquad.
+    // Coefficients are kept apart from the state so every voice can share one set per sample.
+    struct VoiceFilter
+    {
+        struct Coefficients { float a1 = 1.0f, a2 = 0.0f, a3 = 0.0f; };
+
+        static Coefficients makeLowpass(float cutoffHz, double sampleRate) noexcept;
+        void reset() noexcept;
+        // True once the integrators have decayed below about -100 dB, i.e. the tail has rung out.
+        bool isSilent() const noexcept;
+
+        float processSample(int channel, float input, const Coefficients& c) noexcept
+        {
+            auto& s1 = ic1eq[(size_t)channel];
+            auto& s2 = ic2eq[(size_t)channel];
+            const float v3 = input - s2;
+            const float v1 = c.a1 * s1 + c.a2 * v3;
+            const float v2 = s2 + c.a2 * s1 + c.a3 * v3;
+            s1 = 2.0f * v1 - s1;
+            s2 = 2.0f * v2 - s2;
+            return v2;
+        }
+
+        std::array<float, maxRenderChannels> ic1eq {};
+        std::array<float, maxRenderChannels> ic2eq {};
+    };
+
+    // Instruction set used for batches of grains, picked at runtime in prepareToPlay.
+    enum class GrainKernel { scalar, sse2, avx2 };
+
+    static GrainKernel detectGrainKernel() noexcept;
+    static int getGrainKernelWidth(GrainKernel kernel) noexcept;
+    GrainKernel getActiveGrainKernel() const noexcept { return grainKernel; }
+
+    // One note of the synth: its own grain scheduler, filter and mix. A voice keeps sounding
+    // after release until its last grain ends and its filter has rung out. A stolen voice
+    // fades out over a few milliseconds before the note that stole it starts.
+    struct SynthVoice
+    {
+        bool isActive() const noexcept { return isHeld || numGrains > 0 || fadeRemaining > 0 || ! filter.isSilent(); }
+
+        int noteNumber = -1;
+        float velocity = 0.0f;
+        float pitchRatio = 1.0f;
+        bool isHeld = false;
+        juce::uint32 startOrder = 0;
+        bool triggerOnStart = false; // fire one grain on note on instead of waiting for the grid
+        int numGrains = 0;
+        float level = 0.0f;     // peak output over the last block, for quietest-voice stealing
+        int fadeRemaining = 0;  // samples left of the steal fade
+        int pendingNote = -1;   // note waiting for the fade to finish
+        float pendingVelocity = 0.0f;
+        VoiceFilter filter;
+    };
+
+    // Beat position of the block being rendered: the host's PPQ while its transport runs,
+    // otherwise a free-running clock at the host tempo (or currentBpm with no host). Grains and
+    // sequencer steps trigger on a grid in beats, so they stay phase-locked through tempo changes.
+    struct TransportClock
+    {
+        double ppqAt(int sampleInBlock) const noexcept;
+        int findGridTriggers(int startSample, int numSamples, double gridBeats, int* offsets, int maxOffsets) const noexcept;
+
+        double ppqAtBlockStart = 0.0;
+        double ppqPerSample = 0.0;
+        bool isLooping = false;
+        double loopStart = 0.0;
+        double loopEnd = 0.0;
+    };
+
+    // The gesture-driven grain parameters as the audio thread sees them. Each atomic is read
+    // once per block as a target; the value moves towards it by a one-pole step per block and
+    // is ramped linearly across the block, so camera-rate jumps become smooth audio-rate glides.
+    // Cutoff ramps in octaves and pitch in semitones, so both glide evenly by ear.
+    enum GrainRampParameter
+    {
+        durationRamp = 0,
+        positionRamp,
+        densityRamp,
+        pitchRamp,
+        reverseRamp, // 0 forward, 1 reverse; in between grains are cross-faded
+        cutoffRamp,  // log2 of the cutoff in Hz
+        numGrainRamps
+    };
+
+    struct ParameterRamp
+    {
+        void reset(float value) noexcept { start = end = target = value; }
+        void advance(float newTarget, float coefficient) noexcept;
+        bool isMoving() const noexcept { return start != end; }
+        float at(float blockFraction) const noexcept { return start + blockFraction * (end - start); }
+
+        float start = 0.0f;  // at the first sample of the block
+        float end = 0.0f;    // at the first sample of the next block
+        float target = 0.0f;
+    };
+
+    struct SynthNoteEvent
+    {
+        int noteNumber = 0;
+        float velocity = 0.0f; // 0 for note off
+    };
+
+    // Maps the tracker's capture timestamps (wrapping 32-bit microseconds on its own clock) onto
+    // nowMicros. The smallest receive-minus-capture difference is the clock offset plus the
+    // fastest transit; it is taken over a window of messages so the estimate follows drift
+    // between the two clocks. Each instance belongs to one thread.
+    struct GestureClock
+    {
+        static juce::uint32 nowMicros() noexcept;
+        juce::uint32 toLocal(juce::uint32 captureMicros, juce::uint32 receivedMicros) noexcept;
+
+        static constexpr int windowSize = 256;
+        bool hasEstimate = false;
+        juce::uint32 offset = 0;
+        juce::uint32 windowMin = 0;
+        int windowCount = 0;
+    };
+
+    struct DrumTrigger
+    {
+        int track = 0;
+        bool isTimed = false; // untimed triggers play at the start of the next block
+        juce::uint32 dueMicros = 0;
+    };
+
+    struct HandGrainEvent
+    {
+        std::array<float, 6> values {}; // duration, position, cutoff, density, pitch, reverse
+        juce::uint8 mask = 0x3f;        // bit n set when values[n] is to be applied
+        juce::uint32 dueMicros = 0;
+    };
+
+    // A drum hit placed in the current block
+    struct DrumHit
+    {
+        int offset = 0;
+        int track = 0;
     };
 
-    std::vector<Grain> activeGrains;
+    SynthSample::Ptr latestSynthSample;                     // under loadedSampleLock
+    std::atomic<SynthSample*> publishedSynthSample { nullptr };
+    SynthSample::Ptr activeSynthSample;                     // audio thread
+    std::array<DrumSample::Ptr, 4> latestDrumSamples;          // under loadedSampleLock
+    std::array<std::atomic<DrumSample*>, 4> publishedDrumSamples {};
+    std::array<DrumSample::Ptr, 4> activeDrumSamples;          // audio thread, with the playback state below
+    static constexpr int maxDrumVoices = 24;
+    static constexpr int maxVoicesPerDrumTrack = 4;
+    std::array<DrumVoice, maxDrumVoices> drumVoices;    // audio thread
+    juce::uint32 nextDrumVoiceOrder = 0;
+    int drumFadeSamples = 96;
+    std::array<std::atomic<int>, 4> drumChokeGroups {};
+    std::array<std::atomic<float>, 4> trackVolumes { 1.0f, 1.0f, 1.0f, 1.0f };
+    std::array<juce::SmoothedValue<float>, 4> smoothedTrackGains;
+    std::array<std::atomic<juce::uint16>, 4> sequencerPatterns {};
+    std::atomic<bool> sequencerRunning { false };
+    std::atomic<int> sequencerPlayStep { -1 };
+    std::vector<int> sequencerTriggers; // step offsets within the current block
+    std::array<float, 4> drumGainStart {}; // gain ramp across the current block:
+    std::array<float, 4> drumGainStep {};  // start + step * sampleInBlock
+    LockFreeQueue<DrumTrigger, 64> drumTriggers; // from the OSC thread
+    std::array<DrumTrigger, 64> pendingDrumTriggers; // audio thread, popped but not yet due
+    int numPendingDrumTriggers = 0;
+    std::array<DrumHit, 256> drumHits; // audio thread, sorted by offset
+    int numDrumHits = 0;
+    GestureClock gestureClock;          // OSC receiver thread
+    GestureClock sharedGestureClock;    // shared-memory reader thread
+    std::atomic<float> gestureLatencyMs { 25.0f };
+    std::atomic<float> blockLatencyMs { 0.0f };   // one host block, set in prepareToPlay
+    LockFreeQueue<HandGrainEvent, 64> handGrainEvents;       // /handGrain and frame gestures, from the OSC thread
+    LockFreeQueue<HandGrainEvent, 64> sharedHandGrainEvents; // frame gestures from the shared-memory reader
+    std::array<HandGrainEvent, 64> pendingHandGrains;
+    int numPendingHandGrains = 0;
+    juce::uint32 blockStartMicros = 0;
+    ReleasePool releasePool;
+    juce::TimeSliceThread releasePoolThread { "HandGranulator Release Pool" };
+    // Slots 0-3 are the drum tracks, then the synth. A conversion publishes its result only
+    // if its slot's generation has not moved on (a newer file or a new engine rate) meanwhile.
+    static constexpr int synthConversionSlot = 4;
+    static constexpr int numConversionSlots = 5;
+    SampleRateConverter rateConverter;
+    juce::CriticalSection loadedSampleLock; // message thread and conversion jobs, never the audio thread
+    std::array<std::shared_ptr<const DecodedAudio>, numConversionSlots> decodedSources;
+    std::array<bool, numConversionSlots> decodingSlots {}; // under loadedSampleLock
+    std::array<std::atomic<juce::uint32>, numConversionSlots> conversionGenerations {};
+    std::array<std::atomic<float>, numConversionSlots> loadProgress { -1.0f, -1.0f, -1.0f, -1.0f, -1.0f };
+    double conversionRate = 0.0; // engine rate loaded audio is converted to, 0 before prepareToPlay
+    juce::ThreadPool conversionPool { juce::jlimit(1, 8, juce::SystemStats::getNumCpus() - 1) };
+    juce::String activePage { "synth" }; // last page sent to the tracker
+    SharedGestureTransport sharedTransport { *this };
+    juce::TimeSliceThread sharedTransportThread { "HandGranulator Gesture Transport" };
+    GrainPool grainPool;
+    std::array<SynthVoice, maxSynthVoices> synthVoices;
+    juce::uint32 nextVoiceOrder = 0;
+    int stealFadeSamples = 256;
+    LockFreeQueue<SynthNoteEvent, 128> guiNoteEvents;
+    TransportClock transportClock;
+    double freeRunningPpq = 0.0;
+    std::vector<int> gridTriggers; // trigger offsets of the chunk being rendered
+    std::array<ParameterRamp, numGrainRamps> grainRamps;
+    float grainRampScale = 1.0f; // 1 / length of the block the ramps span
+    juce::AudioBuffer<float> voiceMix; // maxRenderChannels channels per voice; grains are summed here before the voice filter
+    GrainWindowBank grainWindows;
+    PolyphaseSincTable sincTable;
+    GrainKernel grainKernel = GrainKernel::scalar;
+    std::vector<juce::uint8> grainBatched; // per pool slot, set when the SIMD kernel rendered it this block
 
-    void spawnGrain();
+    void startSampleLoad(int slot, const juce::File& file, bool reversed = false);
+    std::shared_ptr<const DecodedAudio> decodeAudioFile(const juce::File& file, int slot, juce::uint32 generation, bool reversed);
+    void startSampleConversion(int slot);
+    void publishConvertedSample(int slot, juce::uint32 generation, juce::AudioBuffer<float>& converted);
+    void startDrumVoice(int track) noexcept;
+    void addDrumHit(int offset, int track) noexcept;
+    int samplesUntilDue(juce::uint32 dueMicros) const noexcept;
+    void applyDueHandGrains(int numSamples) noexcept;
+    void scheduleDrumTrigger(int trackIndex, juce::uint32 dueMicros);
+    // fromOscThread picks the clock estimate and grain queue of the calling thread: the OSC
+    // receiver, or the shared-memory reader.
+    void handleHandFrame(const juce::uint8* data, size_t size, juce::uint32 receivedMicros, bool fromOscThread);
+    // autoHorizonMs is the prediction horizon used while landmarkPredictionMs is below zero.
+    void filterReceivedHand(size_t hand, juce::uint32 frameMicros, float autoHorizonMs);
+    void publishReceivedHands(juce::uint32 dueMicros, bool fromOscThread);
+    void runGestureEngine(juce::uint32 dueMicros, bool fromOscThread);
+    void updateDrumGains(int numSamples) noexcept;
+    void mixDrumVoices(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept;
+    void renderDrums(juce::AudioBuffer<float>& buffer, int numSamples) noexcept;
+    void synthNoteOn(int noteNumber, float velocity) noexcept;
+    void synthNoteOff(int noteNumber) noexcept;
+    void startVoice(int voiceIndex, int noteNumber, float velocity) noexcept;
+    int findVoiceToSteal() const noexcept;
+    void retireGrain(int index) noexcept;
+    void resetSynthVoices() noexcept;
+    bool hasActiveSynthVoices() const noexcept;
+    void updateTransportClock(int numSamples);
+    void handleSynthMidi(const juce::MidiMessage& msg) noexcept;
+    void renderSynthRange(juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
+    void updateGrainRamps(int numSamples) noexcept;
+    float grainRampAt(int parameter, int sampleInBlock) const noexcept { return grainRamps[(size_t)parameter].at((float)sampleInBlock * grainRampScale); }
+    bool spawnGrain(int voiceIndex, int sampleInBlock, bool isReverse, float gainScale);
+    void renderGranularBlock(juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
+    bool renderGrain(int index, int startOffset, int endOffset, const GrainRenderContext& context) noexcept;
+    int renderGrainBatches(int numSamples, const GrainRenderContext& context) noexcept;
+    void measureInterpolationCosts();
     
 
 
@@ -4,8 +4,11 @@ import math
 import threading
 from pythonosc import udp_client, dispatcher, osc_server
 
+import os
 import platform
+import struct
 import sys
+import time
 
 from google.protobuf import __version__ as protobuf_version
 
@@ -18,8 +21,6 @@ client = udp_client.SimpleUDPClient("127.0.0.1", 9001)
 finger_to_param = [None, None, None, None]  # Index, Middle, Ring, Pinky
 finger_to_drum = [None, None, None, None]  # default mapping: right-index, right-middle, left-index, left-middle
 
-sample_duration = 10.0  # default fallback
-freeze_parameters = False
 active_page = "synth"
 
 
@@ -28,30 +29,12 @@ pinch_threshold = 0.05
 release_threshold = 0.08
 
 
-# Default values for all 6 parameters (minimum values)
-
-current_values = {
-    "GrainDur":    0.02,
-    "GrainPos":    0.01,
-    "GrainCutOff": 3000.0,
-    "GrainDensity":0.8,
-    "GrainPitch":  1.0,
-    "GrainReverse":0.0,
-    "lfoRate":     0.0
-}
-            
-
 # === OSC SERVER HANDLER ===
 def handle_finger_assignments(address, *args):
     global finger_to_param
     finger_to_param = list(args)
     print("Updated finger assignments:", finger_to_param)
     
-def handle_sample_duration(address, duration):
-    global sample_duration
-    sample_duration = duration
-    print("Received new sample duration:", sample_duration)
-
 def handle_active_page(address, page):
     global active_page
     active_page = page
@@ -69,33 +52,11 @@ def handle_drum_assignments(address, *args):
 
     print("Updated finger drum mapping:", finger_to_drum)
 
-def handle_reset_parameters(address, *args):
-
-    global freeze_parameters, current_values
-
-    freeze_parameters = False
-    
-    # Re-initialise the same dictionary object so every reference sees the change
-    current_values.update({
-        "GrainDur":     0.02,
-        "GrainPos":     0.01,
-        "GrainCutOff":  3000.0,
-        "GrainDensity": 0.8,
-        "GrainPitch":   1.0,
-        "GrainReverse": 0.0,
-        "lfoRate":      0.0,
-    })
-
-    client.send_message("/handGrain", list(current_values.values()))
-    
-
 # === OSC SERVER SETUP ===
 osc_disp = dispatcher.Dispatcher()
 osc_disp.map("/fingerParameters", handle_finger_assignments)
-osc_disp.map("/sampleDuration", handle_sample_duration)
 osc_disp.map("/activePage", handle_active_page)
 osc_disp.map("/fingerDrums", handle_drum_assignments)
-osc_disp.map("/resetParameters", handle_reset_parameters)
 
 
 server = osc_server.ThreadingOSCUDPServer(("127.0.0.1", 9002), osc_disp)
@@ -156,48 +117,157 @@ if not cap.isOpened():
 print("[INFO] Camera opened", flush=True)
 
 # === LOGIC FUNCTIONS ===
-def posmap(x, in_min, in_max, out_min=0.0, out_max=sample_duration, power=2.5):
-    # Normalizza tra 0 e 1
-    norm = (x - in_min) / (in_max - in_min)
-    norm = max(0.0, min(1.0, norm))  # Clamp
+def capture_timestamp():
+    # Frame capture time in wrapping 32-bit microseconds, sent as a signed OSC int32.
+    # JUCE maps it onto its own clock and plays the gesture a fixed latency later.
+    micros = (time.monotonic_ns() // 1000) & 0xFFFFFFFF
+    return micros - (1 << 32) if micros >= (1 << 31) else micros
 
-    # Applica curva non lineare
-    curved = norm ** power
+def trigger_drum_finger(finger_index, captured_at):
+    sample_index = finger_to_drum[finger_index]
+    if sample_index is not None:
+        client.send_message("/triggerDrum", [sample_index, captured_at])
 
-    # Mappa sull’intervallo di uscita
-    return out_min + curved * (out_max - out_min)
+# Both hands in one binary blob (version 1, little-endian): version, visible-hand mask,
+# landmarks per hand, sequence, capture time; then per hand the handedness score and
+# float16 x, y, confidence for each landmark. Must match handleHandFrame in the plugin.
+HAND_FRAME_VERSION = 1
+HAND_FRAME_LANDMARKS = 21
+hand_frame_header = struct.Struct("<BBHII")
+hand_frame_record = struct.Struct("<f" + "eee" * HAND_FRAME_LANDMARKS)
+empty_hand_record = hand_frame_record.pack(0.0, *([0.0] * 3 * HAND_FRAME_LANDMARKS))
+hand_frame_sequence = 0
 
-def linmap(x, in_min, in_max, out_min, out_max, power=2.5):
-    # Normalizza tra 0 e 1
-    norm = (x - in_min) / (in_max - in_min)
-    norm = max(0.0, min(1.0, norm))  # Clamp
+def send_hand_frame(hand_points, hand_scores, captured_at):
+    global hand_frame_sequence
+    hand_frame_sequence = (hand_frame_sequence + 1) & 0xFFFFFFFF
 
-    # Applica curva non lineare
-    curved = norm ** power
+    visible_mask = 0
+    records = []
 
-    # Mappa sull’intervallo di uscita
-    return out_min + curved * (out_max - out_min)
+    for hand_index in (0, 1):
+        points = hand_points[hand_index]
 
-def is_fist(landmarks):
-    finger_tips = [8, 12, 16, 20]
-    finger_pips = [6, 10, 14, 18]
-    return all(landmarks[tip].y > landmarks[pip].y for tip, pip in zip(finger_tips, finger_pips))
+        if points is None:
+            records.append(empty_hand_record)
+            continue
 
-def trigger_drum_finger(finger_index):
-    sample_index = finger_to_drum[finger_index]
-    if sample_index is not None:
-        client.send_message("/triggerDrum", sample_index)
-
-def send_hand_state(hand_index, points):
-    payload = [hand_index, 1 if points is not None else 0]
+        visible_mask |= 1 << hand_index
+        score = hand_scores[hand_index]
+        values = []
 
-    if points is None:
-        payload.extend([0.0] * 42)
-    else:
+        # The Hands solution gives no per-landmark scores, so each landmark carries the hand's score
         for x, y in points:
-            payload.extend([float(x), float(y)])
+            values.extend([x, y, score])
+
+        records.append(hand_frame_record.pack(score, *values))
+
+    header = hand_frame_header.pack(HAND_FRAME_VERSION, visible_mask, HAND_FRAME_LANDMARKS,
+                                    hand_frame_sequence, captured_at & 0xFFFFFFFF)
+    frame = header + b"".join(records)
 
-    client.send_message("/handState", payload)
+    if shared_region is not None:
+        write_shared_hand_frame(frame)
+    else:
+        client.send_message("/handFrame", frame)
+
+# === SHARED MEMORY (optional) ===
+# With --shm <name> the plugin offers a shared-memory region (x86 macOS/Linux): hand frames go into
+# a ring there and the finger/page settings come from a mailbox, instead of over UDP. Drum
+# triggers stay on OSC; the plugin derives the grain parameters from the frames itself.
+# Must match SharedGestureTransport::Region in the plugin.
+# Slot and mailbox sequences are odd while their writer is busy. pack_into stores have no
+# memory fences, which only keeps the sequences ordered with the data on x86, so other
+# machines stay on UDP.
+SHM_MAGIC = 0x4D534748
+SHM_VERSION = 1
+SHM_SLOTS = 16
+SHM_SLOT_SIZE = 4 + hand_frame_header.size + 2 * hand_frame_record.size
+SHM_SLOTS_OFFSET = 16  # after magic, version, tracker pid, frames written
+SHM_CONTROL_OFFSET = SHM_SLOTS_OFFSET + SHM_SLOTS * SHM_SLOT_SIZE
+shm_control = struct.Struct("<I4i" + "32s" * 4 + "16s")
+
+shared_region = None
+shm_frames_written = 0
+shm_control_sequence = 0
+
+def attach_shared_memory():
+    global shared_region
+
+    if "--shm" not in sys.argv[:-1]:
+        return
+
+    name = sys.argv[sys.argv.index("--shm") + 1]
+
+    if platform.machine().lower() not in ("x86_64", "amd64", "i386", "i686", "x86"):
+        print("[WARN] Shared memory needs an x86 machine, using UDP", flush=True)
+        return
+
+    try:
+        from multiprocessing import shared_memory
+
+        try:
+            region = shared_memory.SharedMemory(name=name, track=False)
+        except TypeError:
+            # Before Python 3.13 attaching registers the region for cleanup at exit; the plugin owns it
+            region = shared_memory.SharedMemory(name=name)
+            from multiprocessing import resource_tracker
+            resource_tracker.unregister(region._name, "shared_memory")
+    except Exception as exc:
+        print(f"[WARN] Shared memory {name} unavailable, using UDP: {exc}", flush=True)
+        return
+
+    magic, version = struct.unpack_from("<II", region.buf, 0)
+
+    if magic != SHM_MAGIC or version != SHM_VERSION:
+        print("[WARN] Shared memory layout mismatch, using UDP", flush=True)
+        region.close()
+        return
+
+    struct.pack_into("<I", region.buf, 8, os.getpid())
+    shared_region = region
+    print(f"[INFO] Using shared memory {name}", flush=True)
+
+def write_shared_hand_frame(frame):
+    global shm_frames_written
+    offset = SHM_SLOTS_OFFSET + (shm_frames_written % SHM_SLOTS) * SHM_SLOT_SIZE
+    sequence = struct.unpack_from("<I", shared_region.buf, offset)[0]
+
+    struct.pack_into("<I", shared_region.buf, offset, (sequence + 1) & 0xFFFFFFFF)
+    shared_region.buf[offset + 4:offset + 4 + len(frame)] = frame
+    struct.pack_into("<I", shared_region.buf, offset, (sequence + 2) & 0xFFFFFFFF)
+
+    shm_frames_written = (shm_frames_written + 1) & 0xFFFFFFFF
+    struct.pack_into("<I", shared_region.buf, 12, shm_frames_written)
+
+def poll_shared_controls():
+    global shm_control_sequence
+    fields = shm_control.unpack_from(shared_region.buf, SHM_CONTROL_OFFSET)
+    sequence = fields[0]
+
+    if sequence & 1 or sequence == shm_control_sequence:
+        return
+
+    # Torn read while the plugin was writing: pick it up next frame
+    if struct.unpack_from("<I", shared_region.buf, SHM_CONTROL_OFFSET)[0] != sequence:
+        return
+
+    shm_control_sequence = sequence
+    to_text = lambda raw: raw.split(b"\0", 1)[0].decode("utf-8", "replace")
+
+    handle_finger_assignments("/fingerParameters", *[to_text(raw) for raw in fields[5:9]])
+    handle_drum_assignments("/fingerDrums", *fields[1:5])
+    handle_active_page("/activePage", to_text(fields[9]))
+
+def detach_shared_memory():
+    global shared_region
+
+    if shared_region is not None:
+        struct.pack_into("<I", shared_region.buf, 8, 0)
+        shared_region.close()
+        shared_region = None
+
+attach_shared_memory()
 
 # === MAIN LOOP ===
 while cap.isOpened():
@@ -205,20 +275,25 @@ while cap.isOpened():
     if not ret:
         break
 
+    if shared_region is not None:
+        poll_shared_controls()
+
+    captured_at = capture_timestamp()
+
     frame = cv2.flip(frame, 1)
     img = cv2.cvtColor(frame, cv2.COLOR_BGR2RGB)
     results = hands.process(img)
     hand_points = {0: None, 1: None}
+    hand_scores = {0: 0.0, 1: 0.0}
 
     if results.multi_hand_landmarks and results.multi_handedness:
 
-        left_is_fist = False
-
         for hand_landmarks, hand_handedness in zip(results.multi_hand_landmarks, results.multi_handedness):
             label = hand_handedness.classification[0].label  # "Left" or "Right"
             landmarks = hand_landmarks.landmark
             hand_index = 0 if label == "Left" else 1
             hand_points[hand_index] = [(lm.x, lm.y) for lm in landmarks]
+            hand_scores[hand_index] = hand_handedness.classification[0].score
 
             mp_draw.draw_landmarks(frame, hand_landmarks, mp_hands.HAND_CONNECTIONS)
 
@@ -237,14 +312,14 @@ while cap.isOpened():
                     # Finger 0 = Right Index
                     if dist_index < pinch_threshold and not last_pinched[0]:
                       
-                        trigger_drum_finger(0)
+                        trigger_drum_finger(0, captured_at)
                         last_pinched[0] = True
                     elif dist_index > release_threshold and last_pinched[0]:
                         last_pinched[0] = False
 
                     # Finger 1 = Right Middle
                     if dist_middle < pinch_threshold and not last_pinched[1]:
-                        trigger_drum_finger(1)
+                        trigger_drum_finger(1, captured_at)
                         last_pinched[1] = True
                     elif dist_middle > release_threshold and last_pinched[1]:
                         last_pinched[1] = False
@@ -252,76 +327,23 @@ while cap.isOpened():
                 elif label == "Left":
                     # Finger 2 = Left Index
                     if dist_index < pinch_threshold and not last_pinched[2]:
-                        trigger_drum_finger(2)
+                        trigger_drum_finger(2, captured_at)
                         last_pinched[2] = True
                     elif dist_index > release_threshold and last_pinched[2]:
                         last_pinched[2] = False
 
                     # Finger 3 = Left Middle
                     if dist_middle < pinch_threshold and not last_pinched[3]:
-                        trigger_drum_finger(3)
+                        trigger_drum_finger(3, captured_at)
                         last_pinched[3] = True
                     elif dist_middle > release_threshold and last_pinched[3]:
                         last_pinched[3] = False
 
 
-            # === SYNTH PAGE ===
-            elif active_page == "synth":
-                #print("we are in synth page")
-                if label == "Left" and is_fist(landmarks):
-                    left_is_fist = True
-                    freeze_parameters = True
-                    continue
-
-                elif label == "Right":
-                    # Compute distances from thumb to each fingertip
-                    thumb = landmarks[4]
-                    index_dist = math.hypot(landmarks[8].x - thumb.x, landmarks[8].y - thumb.y)
-                    middle_dist = math.hypot(landmarks[12].x - thumb.x, landmarks[12].y - thumb.y)
-                    ring_dist = math.hypot(landmarks[16].x - thumb.x, landmarks[16].y - thumb.y)
-                    pinky_dist = math.hypot(landmarks[20].x - thumb.x, landmarks[20].y - thumb.y)
-
-                    values = [index_dist, middle_dist, ring_dist, pinky_dist]
-
-                    if not freeze_parameters:
-                        # Update only the parameters controlled by each finger
-                        for finger_id, param in enumerate(finger_to_param):
-                            dist = values[finger_id]
-                            if param == "GrainDur":
-                                max_grain_dur = min(0.5, sample_duration * 0.1)
-                                current_values["GrainDur"] = linmap(dist, 0.02, 0.70, 0.005, max_grain_dur, power=2.5)
-                            elif param == "GrainPos":
-                                current_values["GrainPos"] = posmap(dist, 0.02, 0.70, 0.0, sample_duration, power=2.5)
-                            elif param == "GrainCutOff":
-                                current_values["GrainCutOff"] = linmap(dist, 0.02, 0.70, 50, 15000, power=2.5)
-                            elif param == "GrainDensity":
-                                current_values["GrainDensity"] = linmap(dist, 0.02, 0.70, 0.005, 5, power=2.5)
-                            elif param == "GrainPitch":
-                                current_values["GrainPitch"] = linmap(dist, 0.02, 0.70, -12, +12, power=2.5)
-                            elif param == "GrainReverse":
-                                current_values["GrainReverse"] = 1.0 if dist < 0.05 else 0.0
-                            elif param == "lfoRate":
-                                current_values["lfoRate"] = linmap(dist, 0.02, 0.70, 100, 20000, power=2.5)
-
-                # Only send synth params if on synth page
-                if active_page == "synth" and not freeze_parameters:
-                    
-                    client.send_message("/handGrain", [
-                        current_values["GrainDur"],
-                        current_values["GrainPos"],
-                        current_values["GrainCutOff"],
-                        current_values["GrainDensity"],
-                        current_values["GrainPitch"],
-                        current_values["GrainReverse"],
-                        current_values["lfoRate"]
-                    ])
-
-        # Unfreeze if hand is open again
-        if active_page == "synth" and not left_is_fist:
-            freeze_parameters = False
-
-    send_hand_state(0, hand_points[0])
-    send_hand_state(1, hand_points[1])
+            # The synth page's finger mappings and fist freeze run in the plugin,
+            # straight from the hand frames sent below.
+
+    send_hand_frame(hand_points, hand_scores, captured_at)
 
 # Show window
 # cv2.imshow("Hand Tracker", frame)
@@ -331,5 +353,6 @@ while cap.isOpened():
 #     break
 
 cap.release()
+detach_shared_memory()
 
 #cv2.destroyAllWindows()